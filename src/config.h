@@ -16,8 +16,24 @@
 #define MOEDAS_INICIAL 0
 #define MOEDAS_POR_MODULO 10
 
+// Mural
+#define MURAL_SHARDS 8               // shards dos ativos, cada um com seu lock
+#define MURAL_RESOLVED_KEEP 64       // resolvidos mantidos na lista (-1 = todos)
+#define MURAL_MAX_BOMBS 8            // bombas simultâneas (--bomb / --bombs)
+
+// Coordenador
+#define COORD_QUEUE_CAPACITY 256     // fila de comandos (potência de 2)
+
+// Gravador (--record): registros de 32 bytes no anel do arquivo (potência de 2)
+#define REC_CAPACITY (1 << 20)
+
+// Telemetria (--telemetry): fila em memória (potência de 2) e período máximo entre gravações
+#define TELEMETRY_QUEUE (1 << 14)
+#define TELEMETRY_FLUSH_MS 250
+
 // UI / logs
 #define LOG_LINES 256
 #define UI_REFRESH_MS 100            // taxa de refresh da UI em ms
+#define UI_LINGER_MS 3000            // fim de rodada: tabuleiro congelado na tela (--linger)
 
 #endif // CONFIG_H
\ No newline at end of file
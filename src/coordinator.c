@@ -2,110 +2,276 @@
 #include "coordinator.h"
 #include "mural.h"
 #include "tedax.h"
-#include "ui.h"
+#include "eventlog.h"
+#include "config.h"
+#include "metrics.h"
+#include "sim.h"
+#include "lockprof.h"
+#include "recorder.h"
+#include "park.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #define CMD_MAX 128
-#define QUEUE_SIZE 64
 
-static char queue[QUEUE_SIZE][CMD_MAX];
-static int q_head = 0;
-static int q_tail = 0;
+// =====================================================
+//  Fila de comandos: anel MPSC sem lock (Vyukov)
+// =====================================================
+// Cada célula tem um número de sequência: produtores disputam a posição
+// com CAS em enq_pos e publicam a célula com seq = pos + 1; o consumidor
+// (única thread do coordenador) libera a célula com seq = pos + capacidade.
+typedef struct {
+    atomic_size_t seq;
+    long long enq_ns;          // publicação (métrica de espera na fila)
+    char cmd[CMD_MAX];
+} cmd_cell_t;
+
+static cmd_cell_t *ring = NULL;
+static size_t ring_cap = 0;
+static size_t ring_mask = 0;
+static size_t requested_cap = COORD_QUEUE_CAPACITY;
+static atomic_size_t enq_pos;
+static size_t deq_pos = 0;                 // só o consumidor mexe
+static atomic_ulong dropped_commands;
+
+// o mutex/cond só é usado quando o coordenador vai dormir com a fila vazia
 static pthread_mutex_t q_mut = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  q_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int consumer_sleeping;
+static atomic_int autopilot;
+static atomic_int dispatch_pending;        // coord_notify desde o último despacho
 static pthread_t coord_thread;
-static int running = 1;
-
-void coord_enqueue_command(const char *cmd) {
-    pthread_mutex_lock(&q_mut);
-    int next = (q_tail + 1) % QUEUE_SIZE;
-    if (next != q_head) {
-        strncpy(queue[q_tail], cmd, CMD_MAX);
-        queue[q_tail][CMD_MAX-1] = '\0';
-        q_tail = next;
-        pthread_cond_signal(&q_cond);
-    }
-    pthread_mutex_unlock(&q_mut);
+static park_t coord_park = PARK_INITIALIZER;   // a thread estaciona entre rodadas
+static atomic_int running;
+
+static size_t round_pow2(size_t n) {
+    size_t c = 2;
+    while (c < n) c <<= 1;
+    return c;
+}
+
+// A fila é alocada uma vez e nunca trocada: a UI pode tentar enfileirar
+// depois do shutdown, então o buffer vive até o fim do programa
+static int ring_alloc(size_t cap) {
+    cmd_cell_t *n = malloc(cap * sizeof(cmd_cell_t));
+    if (!n) return -1;
+    ring = n;
+    ring_cap = cap;
+    ring_mask = ring_cap - 1;
+    return 0;
+}
+
+void coord_set_queue_capacity(size_t capacity) {
+    if (ring) return;   // já dimensionada: vale a do primeiro coord_start
+    requested_cap = round_pow2(capacity);
+    ring_alloc(requested_cap);
+}
+
+unsigned long coord_dropped_commands(void) {
+    return atomic_load(&dropped_commands);
 }
 
-static int dequeue(char *out) {
-    pthread_mutex_lock(&q_mut);
-    while (running && q_head == q_tail) {
-        pthread_cond_wait(&q_cond, &q_mut);
+int coord_enqueue_command(const char *cmd) {
+    if (!ring || !atomic_load(&running)) return COORD_ESTOPPED;
+
+    cmd_cell_t *cell;
+    size_t pos = atomic_load_explicit(&enq_pos, memory_order_relaxed);
+    for (;;) {
+        cell = &ring[pos & ring_mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enq_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (dif < 0) {
+            // cheia: o chamador decide (descartar, tentar de novo, avisar)
+            atomic_fetch_add(&dropped_commands, 1);
+            metrics_inc(MET_C_DROPPED_CMDS);
+            return COORD_EFULL;
+        } else {
+            pos = atomic_load_explicit(&enq_pos, memory_order_relaxed);
+        }
     }
-    if (!running) {
-        pthread_mutex_unlock(&q_mut);
-        return 0;
+    strncpy(cell->cmd, cmd, CMD_MAX);
+    cell->cmd[CMD_MAX-1] = '\0';
+    cell->enq_ns = sim_now_ns();
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+    // par com a fence em wait_for_commands: ou o consumidor vê a célula,
+    // ou nós vemos que ele está dormindo e o acordamos
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&consumer_sleeping, memory_order_relaxed)) {
+        LOCK(&q_mut);
+        pthread_cond_signal(&q_cond);
+        UNLOCK(&q_mut);
     }
-    strncpy(out, queue[q_head], CMD_MAX);
-    q_head = (q_head + 1) % QUEUE_SIZE;
-    pthread_mutex_unlock(&q_mut);
+    return COORD_OK;
+}
+
+static int ring_ready(void) {
+    size_t seq = atomic_load_explicit(&ring[deq_pos & ring_mask].seq, memory_order_acquire);
+    return seq == deq_pos + 1;
+}
+
+static int try_dequeue(char *out) {
+    cmd_cell_t *cell = &ring[deq_pos & ring_mask];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != deq_pos + 1) return 0;
+    memcpy(out, cell->cmd, CMD_MAX);
+    metrics_record_us(MET_H_COORD_QUEUE, (sim_now_ns() - cell->enq_ns) / 1000);
+    atomic_store_explicit(&cell->seq, deq_pos + ring_cap, memory_order_release);
+    deq_pos++;
     return 1;
 }
 
-static void handle_auto_assign_generic() {
-    module_t *m = mural_pop();
-    if (!m) { log_event("[COORD] Mural vazio!"); return; }
-    int tid = tedax_request_auto(m);
-    if (tid < 0) {
-        log_event("[COORD] Sem recursos p/ M%d. Re-enfileirado.", m->id);
-        mural_requeue(m);
-    } else {
-        log_event("[COORD] Auto: M%d -> T%d", m->id, tid);
+// dorme até haver comando publicado, aviso ao piloto ou o coordenador ser encerrado
+static void wait_for_commands(void) {
+    LOCK(&q_mut);
+    atomic_store_explicit(&consumer_sleeping, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (atomic_load(&running) && !ring_ready() && !atomic_load(&dispatch_pending)) {
+        COND_WAIT(&q_cond, &q_mut);
+    }
+    atomic_store_explicit(&consumer_sleeping, 0, memory_order_relaxed);
+    UNLOCK(&q_mut);
+}
+
+// Despacho em lote: reserva todos os pares (tedax ocioso, bancada livre)
+// e retira, numa seleção entre os shards do mural, os módulos que vão
+// ocupá-los. Tedax e bancadas são intercambiáveis, então o emparelhamento
+// se reduz a escolher quais módulos servir (mural_take_batch); pares que
+// sobram (o mural encolheu no meio) são devolvidos, nada é re-enfileirado.
+static int dispatch_batch(int quiet) {
+    int tids[MURAL_BATCH_MAX], bids[MURAL_BATCH_MAX];
+    module_t *mods[MURAL_BATCH_MAX];
+
+    int pending = mural_count();
+    int want = pending < MURAL_BATCH_MAX ? pending : MURAL_BATCH_MAX; // tamanho de tids/bids
+    int pairs = want > 0 ? tedax_reserve_idle(tids, bids, want) : 0;
+    int n = mural_take_batch(mods, pairs);
+
+    for (int i = 0; i < n; ++i) {
+        tedax_start_reserved(tids[i], bids[i], mods[i]);
+        log_record(LOG_EV_COORD_AUTO, mods[i]->id, tids[i], bids[i], 0);
     }
+    for (int i = n; i < pairs; ++i) tedax_cancel_reserved(tids[i], bids[i]);
+
+    if (quiet) return n;
+    if (pending == 0) log_record(LOG_EV_COORD_EMPTY, -1, -1, -1, 0);
+    else if (n == 0) log_record(LOG_EV_COORD_NO_RESOURCES, -1, -1, -1, pending);
+    return n;
 }
 
-static void handle_manual_assign(const char *cmd) {
+static int handle_auto_assign_generic(void) { return dispatch_batch(0); }
+
+static int handle_manual_assign(const char *cmd) {
     int m_id, t_id, b_id; char instr[64];
     int parsed = 0;
     if (sscanf(cmd, "M %d %d %d %[^\n]", &m_id, &t_id, &b_id, instr) == 4) parsed = 1;
     else if (sscanf(cmd, "M %d %[^\n]", &m_id, instr) == 2) parsed = 0;
-    else { log_event("[COORD] Erro comando: %s", cmd); return; }
+    else { log_event("[COORD] Erro comando: %s", cmd); return 0; }
 
     module_t *m = mural_pop_by_id(m_id);
-    if (!m) { log_event("[COORD] Falha: M%d nao existe.", m_id); return; }
+    if (!m) { log_record(LOG_EV_COORD_NOT_FOUND, m_id, -1, -1, 0); return 0; }
     snprintf(m->instruction, sizeof(m->instruction), "%s", instr);
 
     if (parsed) {
         if (!tedax_request_manual(m, t_id, b_id, 0)) {
-            log_event("[COORD] Falha atribuir M%d. Re-enfileirado.", m_id);
+            log_record(LOG_EV_COORD_ASSIGN_FAILED, m_id, -1, -1, 0);
             mural_requeue(m);
+            return 0;
         }
     } else {
         if (tedax_request_auto(m) < 0) {
-            log_event("[COORD] M%d sem recursos. Re-enfileirado.", m_id);
+            log_record(LOG_EV_COORD_MANUAL_NO_RES, m_id, -1, -1, 0);
             mural_requeue(m);
+            return 0;
         }
     }
+    return 1;
+}
+
+int coord_execute_command(const char *cmd) {
+    rec_command(cmd);
+    if (cmd[0] == 'A' || cmd[0] == 'a') return handle_auto_assign_generic();
+    if (cmd[0] == 'M') return handle_manual_assign(cmd);
+    log_event("[COORD] Desconhecido: %s", cmd);
+    return 0;
+}
+
+int coord_autopilot_dispatch(void) {
+    return dispatch_batch(1);
 }
 
 static void* coordinator_fn(void *arg) {
     (void)arg; char cmd[CMD_MAX];
-    while (running) {
-        if (!dequeue(cmd)) continue;
-        if (cmd[0] == 'A' || cmd[0] == 'a') handle_auto_assign_generic();
-        else if (cmd[0] == 'M') handle_manual_assign(cmd);
-        else if (cmd[0] == 'Q') { running = 0; break; }
-        else log_event("[COORD] Desconhecido: %s", cmd);
-    }
+    do {
+        while (atomic_load(&running)) {
+            wait_for_commands();
+            // drena tudo o que foi publicado numa única acordada
+            while (atomic_load(&running) && try_dequeue(cmd)) {
+                if (cmd[0] == 'Q') { atomic_store(&running, 0); break; }
+                coord_execute_command(cmd);
+            }
+            // o piloto não reclama de mural vazio: só ocupa o que estiver livre
+            if (atomic_exchange(&dispatch_pending, 0) && atomic_load(&autopilot))
+                dispatch_batch(1);
+        }
+    } while (park_enter(&coord_park));
     return NULL;
 }
 
+void coord_set_autopilot(int on) {
+    atomic_store(&autopilot, on ? 1 : 0);
+    if (on) coord_notify(); // despacha o que já está à espera
+}
+
+int coord_autopilot(void) { return atomic_load(&autopilot); }
+
+void coord_notify(void) {
+    if (!atomic_load_explicit(&autopilot, memory_order_relaxed)) return;
+    atomic_store(&dispatch_pending, 1);
+    // mesmo protocolo de coord_enqueue_command com wait_for_commands
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&consumer_sleeping, memory_order_relaxed)) {
+        LOCK(&q_mut);
+        pthread_cond_signal(&q_cond);
+        UNLOCK(&q_mut);
+    }
+}
+
 int coord_start(void) {
-    // Reset da fila ao iniciar
-    q_head = 0; q_tail = 0;
-    running = 1;
-    if (pthread_create(&coord_thread, NULL, coordinator_fn, NULL) != 0) return 1;
+    // Zera a fila ao iniciar (alocada só na primeira vez). A thread da
+    // rodada anterior está estacionada e não toca na fila.
+    if (!ring && ring_alloc(requested_cap) != 0) return 1;
+    for (size_t i = 0; i < ring_cap; ++i) atomic_init(&ring[i].seq, i);
+    atomic_store(&enq_pos, 0);
+    deq_pos = 0;
+    atomic_store(&dropped_commands, 0);
+    atomic_store(&consumer_sleeping, 0);
+    atomic_store(&dispatch_pending, atomic_load(&autopilot)); // 1º despacho ao iniciar
+    atomic_store(&running, 1);
+    if (park_threads(&coord_park) > 0) park_open(&coord_park);
+    else if (park_spawn(&coord_park, &coord_thread, coordinator_fn, NULL) != 0) return 1;
     return 0;
 }
 
 void coord_shutdown(void) {
-    running = 0;
+    atomic_store(&running, 0);
+    LOCK(&q_mut);
     pthread_cond_broadcast(&q_cond);
-    pthread_join(coord_thread, NULL);
-}
\ No newline at end of file
+    UNLOCK(&q_mut);
+    park_close(&coord_park);
+    unsigned long lost = coord_dropped_commands();
+    if (lost) log_event("[COORD] %lu comandos descartados (fila cheia)", lost);
+}
+
+void coord_exit(void) {
+    if (park_threads(&coord_park) == 0) return;
+    park_exit(&coord_park, &coord_thread);
+}
@@ -2,14 +2,48 @@
 #define COORDINATOR_H
 
 #include <pthread.h>
+#include <stddef.h>
+
+// Códigos de retorno de coord_enqueue_command
+#define COORD_OK        0
+#define COORD_EFULL    -1   // fila cheia: comando descartado (contado em coord_dropped_commands)
+#define COORD_ESTOPPED -2   // coordenador não está a correr
+
+// Capacidade da fila (arredondada para potência de 2). Chamar antes do primeiro
+// coord_start: a fila é alocada uma vez e não muda depois
+void coord_set_queue_capacity(size_t capacity);
 
 // Inicializa coordenador (fila de comandos + thread)
 int coord_start(void);
 
-// Encerra coordenador (finaliza thread)
+// Encerra a rodada do coordenador: a thread estaciona até o próximo coord_start
 void coord_shutdown(void);
 
-// Enfileira comandos vindos da UI (como "3f2pp", "a", "d"...)
-void coord_enqueue_command(const char *cmd);
+// Fim do programa: encerra de vez a thread do coordenador
+void coord_exit(void);
+
+// Enfileira comandos vindos da UI (como "3f2pp", "a", "d"...).
+// Sem lock: pode ser chamada por qualquer número de produtores.
+int coord_enqueue_command(const char *cmd);
+
+// Quantos comandos foram recusados por fila cheia desde o último coord_start
+unsigned long coord_dropped_commands(void);
+
+// Executa um comando na thread chamadora, sem passar pela fila
+// (modo simulação). Retorna quantos módulos foram atribuídos.
+int coord_execute_command(const char *cmd);
+
+// Piloto automático: o coordenador despacha sozinho sempre que houver
+// tedax e bancada livres e módulo à espera. Vale até ser desligado.
+void coord_set_autopilot(int on);
+int coord_autopilot(void);
+
+// Um despacho do piloto na thread chamadora, sem mensagens (replay de
+// uma partida jogada com o piloto, no modo simulação)
+int coord_autopilot_dispatch(void);
+
+// Aviso de mudança relevante para o piloto (módulo novo, tedax livre).
+// Barato e sem lock; não faz nada com o piloto desligado.
+void coord_notify(void);
 
 #endif
@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+#include "eventlog.h"
+#include "config.h"
+#include "sim.h"
+#include "ui.h"
+#include "telemetry.h"
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+// O anel precisa de tamanho potência de 2 (índice = ticket & máscara)
+#if (LOG_LINES & (LOG_LINES - 1)) != 0
+#error "LOG_LINES deve ser potencia de 2"
+#endif
+
+// Cada slot funciona como um seqlock: seq = 0 enquanto o produtor escreve,
+// seq = ticket + 1 depois de publicado. O leitor copia e confere seq de novo.
+typedef struct {
+    atomic_ullong seq;
+    log_record_t rec;
+} log_slot_t;
+
+static log_slot_t ring[LOG_LINES];
+static atomic_ullong log_head;
+
+static log_record_t* claim(unsigned long long *ticket) {
+    *ticket = atomic_fetch_add_explicit(&log_head, 1, memory_order_relaxed);
+    log_slot_t *s = &ring[*ticket & (LOG_LINES - 1)];
+    atomic_store_explicit(&s->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return &s->rec;
+}
+
+static void publish(unsigned long long ticket) {
+    atomic_store_explicit(&ring[ticket & (LOG_LINES - 1)].seq, ticket + 1, memory_order_release);
+    ui_wake();
+}
+
+static int severity_of(log_code_t code) {
+    switch (code) {
+        case LOG_EV_TEDAX_EXPLODED:
+        case LOG_EV_TEDAX_FAILED:
+        case LOG_EV_WATCHER_TIMEOUT:
+            return LOG_SEV_ERR;
+        case LOG_EV_TEDAX_DISARMED:
+            return LOG_SEV_OK;
+        case LOG_EV_COORD_AUTO:
+        case LOG_EV_ASSIGN:
+        case LOG_EV_UI_AUTO:
+            return LOG_SEV_ACCENT;
+        default:
+            return LOG_SEV_INFO;
+    }
+}
+
+// =====================================================
+//  Produtores
+// =====================================================
+void log_record(log_code_t code, int module_id, int tedax_id, int bench_id, int arg) {
+    unsigned long long t;
+    log_record_t *r = claim(&t);
+    r->seq = t;
+    r->ts_ms = sim_wall_ms();
+    r->code = code;
+    r->module_id = module_id;
+    r->tedax_id = tedax_id;
+    r->bench_id = bench_id;
+    r->arg = arg;
+    r->severity = severity_of(code);
+    r->text[0] = '\0';
+    telemetry_log(r);   // copia antes de publicar: depois o slot pode ser reciclado
+    publish(t);
+}
+
+void log_event(const char *fmt, ...) {
+    unsigned long long t;
+    log_record_t *r = claim(&t);
+    va_list ap; va_start(ap, fmt);
+    vsnprintf(r->text, sizeof(r->text), fmt, ap);
+    va_end(ap);
+    r->seq = t;
+    r->ts_ms = sim_wall_ms();
+    r->code = LOG_EV_TEXT;
+    r->module_id = r->tedax_id = r->bench_id = r->arg = -1;
+    // texto livre: classificado uma única vez, na escrita
+    if (strstr(r->text,"EXPLODIU")||strstr(r->text,"FALHOU")||strstr(r->text,"timeout")) r->severity = LOG_SEV_ERR;
+    else if (strstr(r->text,"DESARMADO")||strstr(r->text,"sucesso")) r->severity = LOG_SEV_OK;
+    else if (strstr(r->text,"Auto")||strstr(r->text,"ASSIGN")) r->severity = LOG_SEV_ACCENT;
+    else r->severity = LOG_SEV_INFO;
+    telemetry_log(r);
+    publish(t);
+}
+
+// =====================================================
+//  Consumidor
+// =====================================================
+unsigned long log_version(void) {
+    return (unsigned long)atomic_load(&log_head);
+}
+
+void log_reset(void) {
+    for (int i = 0; i < LOG_LINES; ++i) atomic_store(&ring[i].seq, 0);
+    atomic_store(&log_head, 0);
+}
+
+// copia o registro do ticket t; 0 se foi sobrescrito ou está a meio da escrita
+static int read_ticket(unsigned long long t, log_record_t *out) {
+    log_slot_t *s = &ring[t & (LOG_LINES - 1)];
+    unsigned long long s1 = atomic_load_explicit(&s->seq, memory_order_acquire);
+    if (s1 != t + 1) return 0;
+    memcpy(out, &s->rec, sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&s->seq, memory_order_relaxed) == s1;
+}
+
+int log_read_recent(log_record_t *out, int max) {
+    unsigned long long head = atomic_load_explicit(&log_head, memory_order_acquire);
+    int n = 0;
+    for (unsigned long long i = 0; i < LOG_LINES && i < head && n < max; ++i) {
+        if (read_ticket(head - 1 - i, &out[n])) n++;
+    }
+    return n;
+}
+
+static const char *code_names[] = {
+    "text", "gen_created", "mural_added", "mural_requeued", "watcher_timeout",
+    "coord_empty", "coord_no_resources", "coord_auto", "coord_not_found",
+    "coord_assign_failed", "coord_manual_no_res", "tedax_wait_bench",
+    "tedax_bench_taken", "tedax_bench_preset", "tedax_exploded", "tedax_ai_failed",
+    "tedax_disarmed", "tedax_failed", "assign", "auto", "manual", "ui_auto",
+};
+_Static_assert(sizeof(code_names) / sizeof(code_names[0]) == LOG_EV_COUNT, "code_names fora de sincronia com log_code_t");
+
+const char* log_code_name(log_code_t code) {
+    return (code >= 0 && code < LOG_EV_COUNT) ? code_names[code] : "?";
+}
+
+int log_format(const log_record_t *r, char *buf, int len) {
+    time_t secs = (time_t)(r->ts_ms / 1000);
+    struct tm tm;
+    localtime_r(&secs, &tm);
+    int n = snprintf(buf, len, "[%02d:%02d:%02d] ", tm.tm_hour, tm.tm_min, tm.tm_sec);
+    if (n < 0 || n >= len) return n;
+    char *p = buf + n; int rem = len - n;
+    int M = r->module_id, T = r->tedax_id, B = r->bench_id;
+    switch (r->code) {
+        case LOG_EV_TEXT:               return n + snprintf(p, rem, "%s", r->text);
+        case LOG_EV_GEN_CREATED:        return n + snprintf(p, rem, "[GEN] M%d gerado (tipo %d)", M, r->arg);
+        case LOG_EV_MURAL_ADDED:        return n + snprintf(p, rem, "[MURAL] M%d adicionado", M);
+        case LOG_EV_MURAL_REQUEUED:     return n + snprintf(p, rem, "[MURAL] M%d re-enfileirado", M);
+        case LOG_EV_WATCHER_TIMEOUT:    return n + snprintf(p, rem, "[WATCHER] M%d TIMEOUT — requeue", M);
+        case LOG_EV_COORD_EMPTY:        return n + snprintf(p, rem, "[COORD] Mural vazio!");
+        case LOG_EV_COORD_NO_RESOURCES: return n + snprintf(p, rem, "[COORD] Sem tedax/bancada livre (%d no mural)", r->arg);
+        case LOG_EV_COORD_AUTO:         return n + snprintf(p, rem, "[COORD] Auto: M%d -> T%d", M, T);
+        case LOG_EV_COORD_NOT_FOUND:    return n + snprintf(p, rem, "[COORD] Falha: M%d nao existe.", M);
+        case LOG_EV_COORD_ASSIGN_FAILED:return n + snprintf(p, rem, "[COORD] Falha atribuir M%d. Re-enfileirado.", M);
+        case LOG_EV_COORD_MANUAL_NO_RES:return n + snprintf(p, rem, "[COORD] M%d sem recursos. Re-enfileirado.", M);
+        case LOG_EV_TEDAX_WAIT_BENCH:   return n + snprintf(p, rem, "[T%d] aguardando bancada para M%d...", T, M);
+        case LOG_EV_TEDAX_BENCH_TAKEN:  return n + snprintf(p, rem, "[T%d] bancada %d ocupada para M%d", T, B, M);
+        case LOG_EV_TEDAX_BENCH_PRESET: return n + snprintf(p, rem, "[T%d] bancada %d confirmada (pre-assign) M%d", T, B, M);
+        case LOG_EV_TEDAX_EXPLODED:     return n + snprintf(p, rem, "[T%d] 💥 M%d EXPLODIU na mao! (Timeout)", T, M);
+        case LOG_EV_TEDAX_AI_FAILED:    return n + snprintf(p, rem, "[T%d] IA falhou no desarmamento automatico.", T);
+        case LOG_EV_TEDAX_DISARMED:     return n + snprintf(p, rem, "[T%d] ✔ M%d DESARMADO (+%d Gold)", T, M, r->arg);
+        case LOG_EV_TEDAX_FAILED:       return n + snprintf(p, rem, "[T%d] ✖ M%d FALHOU — re-enfileirado", T, M);
+        case LOG_EV_ASSIGN:             return n + snprintf(p, rem, "[ASSIGN] M%d → T%d", M, T);
+        case LOG_EV_AUTO:               return n + snprintf(p, rem, "[AUTO] M%d -> T%d B%d", M, T, B);
+        case LOG_EV_MANUAL:             return n + snprintf(p, rem, "[MANUAL] M%d -> T%d B%d (manual)", M, T, B);
+        case LOG_EV_UI_AUTO:            return n + snprintf(p, rem, "[UI] Auto-assign");
+        default:                        return n + snprintf(p, rem, "[?] evento %d", r->code);
+    }
+}
+
+void log_dump(FILE *f) {
+    log_record_t recs[LOG_LINES];
+    int n = log_read_recent(recs, LOG_LINES);
+    char line[LOG_TEXT_MAX + 64];
+    for (int i = n - 1; i >= 0; --i) {
+        log_format(&recs[i], line, sizeof(line));
+        fprintf(f, "%s\n", line);
+    }
+}
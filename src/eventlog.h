@@ -0,0 +1,62 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <stdio.h>
+
+// Log de eventos: anel fixo de LOG_LINES registros binários, sem lock e
+// sem alocação. Produtores gravam só códigos e ids; o texto é montado
+// por quem consome (painel da UI, exportação).
+
+typedef enum {
+    LOG_EV_TEXT = 0,             // mensagem livre (caminhos frios)
+    LOG_EV_GEN_CREATED,          // M, arg = tipo
+    LOG_EV_MURAL_ADDED,          // M
+    LOG_EV_MURAL_REQUEUED,       // M
+    LOG_EV_WATCHER_TIMEOUT,      // M
+    LOG_EV_COORD_EMPTY,
+    LOG_EV_COORD_NO_RESOURCES,   // arg = módulos pendentes
+    LOG_EV_COORD_AUTO,           // M, T
+    LOG_EV_COORD_NOT_FOUND,      // M
+    LOG_EV_COORD_ASSIGN_FAILED,  // M
+    LOG_EV_COORD_MANUAL_NO_RES,  // M
+    LOG_EV_TEDAX_WAIT_BENCH,     // T, M
+    LOG_EV_TEDAX_BENCH_TAKEN,    // T, B, M
+    LOG_EV_TEDAX_BENCH_PRESET,   // T, B, M
+    LOG_EV_TEDAX_EXPLODED,       // T, M
+    LOG_EV_TEDAX_AI_FAILED,      // T
+    LOG_EV_TEDAX_DISARMED,       // T, M, arg = gold
+    LOG_EV_TEDAX_FAILED,         // T, M
+    LOG_EV_ASSIGN,               // M, T
+    LOG_EV_AUTO,                 // M, T, B
+    LOG_EV_MANUAL,               // M, T, B
+    LOG_EV_UI_AUTO,
+    LOG_EV_COUNT
+} log_code_t;
+
+// Classe visual de um registro (cor no painel de log)
+typedef enum { LOG_SEV_INFO = 0, LOG_SEV_OK, LOG_SEV_ERR, LOG_SEV_ACCENT } log_severity_t;
+
+#define LOG_TEXT_MAX 112
+
+typedef struct {
+    unsigned long long seq;      // ordem global de escrita
+    long long ts_ms;             // hora de parede (virtual no modo --sim)
+    int code;
+    int module_id, tedax_id, bench_id, arg;
+    int severity;
+    char text[LOG_TEXT_MAX];     // só LOG_EV_TEXT
+} log_record_t;
+
+// Produtores (qualquer thread)
+void log_record(log_code_t code, int module_id, int tedax_id, int bench_id, int arg);
+void log_event(const char *fmt, ...);   // texto livre: formata na hora, use fora dos caminhos quentes
+
+// Consumidor
+void log_reset(void);
+unsigned long log_version(void);                   // muda a cada registro publicado
+int log_read_recent(log_record_t *out, int max);   // mais recentes primeiro
+int log_format(const log_record_t *r, char *buf, int len);
+const char* log_code_name(log_code_t code);        // nome curto estável ("tedax_disarmed")
+void log_dump(FILE *f);                            // mais antigos primeiro
+
+#endif // EVENTLOG_H
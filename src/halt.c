@@ -0,0 +1,55 @@
+#include "halt.h"
+#include "lockprof.h"
+#include "sim.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+static pthread_mutex_t halt_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t halt_cond;
+static pthread_once_t halt_once = PTHREAD_ONCE_INIT;
+static atomic_int halt_flag;              // halt_reason_t
+
+// criada uma vez só: reinicializar uma condição com alguém esperando nela
+// (ou sinalizando) é indefinido
+static void halt_init(void) {
+    sim_cond_init(&halt_cond);
+}
+
+void halt_reset(void) {
+    pthread_once(&halt_once, halt_init);
+    LOCK(&halt_mutex);
+    atomic_store(&halt_flag, 0);
+    UNLOCK(&halt_mutex);
+}
+
+void halt_raise(halt_reason_t why) {
+    pthread_once(&halt_once, halt_init);
+    LOCK(&halt_mutex);
+    if (!atomic_load(&halt_flag)) {
+        atomic_store(&halt_flag, why);
+        pthread_cond_broadcast(&halt_cond);
+    }
+    UNLOCK(&halt_mutex);
+}
+
+halt_reason_t halt_raised(void) {
+    return (halt_reason_t)atomic_load(&halt_flag);
+}
+
+halt_reason_t halt_wait_until(long long at_ms) {
+    pthread_once(&halt_once, halt_init);
+    struct timespec until;
+    sim_abs_timespec(at_ms, &until);
+    LOCK(&halt_mutex);
+    int rc = 0;
+    while (!atomic_load(&halt_flag) && rc == 0)
+        rc = COND_TIMEDWAIT(&halt_cond, &halt_mutex, &until);
+    halt_reason_t why = (halt_reason_t)atomic_load(&halt_flag);
+    UNLOCK(&halt_mutex);
+    return why;
+}
+
+halt_reason_t halt_wait_ms(long long ms) {
+    return halt_wait_until(sim_now_ms() + ms);
+}
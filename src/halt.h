@@ -0,0 +1,25 @@
+#ifndef HALT_H
+#define HALT_H
+
+// Fim de rodada: um pedido de parada compartilhado por um condvar no
+// relógio do jogo. O laço principal dorme nele até o prazo da partida,
+// e quem muda o estado do jogo avisa na hora: o mural ao atingir a meta,
+// a UI ao sair com Q. O primeiro motivo registrado vale.
+
+typedef enum {
+    HALT_NONE = 0,
+    HALT_QUIT,          // jogador saiu (Q)
+    HALT_WIN,           // score atingiu WIN_SCORE_TARGET
+    HALT_TIME           // prazo da partida venceu
+} halt_reason_t;
+
+void halt_reset(void);                  // nova rodada: limpa o pedido
+void halt_raise(halt_reason_t why);     // pede a parada e acorda quem espera
+halt_reason_t halt_raised(void);
+
+// Dorme até o instante at_ms do relógio do jogo (ou ms milissegundos) ou
+// até halt_raise; retorna o motivo, ou HALT_NONE se o prazo chegou antes
+halt_reason_t halt_wait_until(long long at_ms);
+halt_reason_t halt_wait_ms(long long ms);
+
+#endif // HALT_H
@@ -0,0 +1,327 @@
+#define _POSIX_C_SOURCE 200809L
+#include "loadgen.h"
+#include "mural.h"
+#include "eventlog.h"
+#include "sim.h"
+#include "lockprof.h"
+#include "recorder.h"
+#include "rng.h"
+#include "park.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Entrada do trace: instante relativo ao início da rodada
+typedef struct {
+    long long at_ms;
+    int type;               // -1 = sorteio
+    int timeout_ms;         // 0 = o da configuração
+} trace_entry_t;
+
+// Estado de um produtor. Chegadas são medidas num relógio "ativo": em
+// bursty ele só anda dentro das janelas ON e é mapeado para o tempo real.
+typedef struct {
+    rng_t rng;
+    rng_t mod_rng;          // conteúdo dos módulos deste produtor
+    double active_ms;       // próxima chegada no relógio ativo
+    double gap_ms;          // intervalo médio deste produtor (taxa da bomba / K)
+    int cursor;             // trace: próxima entrada (passo = producers)
+    int bomb;
+} producer_t;
+
+static loadgen_config_t conf;
+static producer_t prod[LOADGEN_MAX_PRODUCERS];
+static int n_prod = 0;
+static long long start_ms = 0;
+static atomic_int next_id;
+static atomic_int generated;
+
+static trace_entry_t *trace = NULL;
+static int trace_len = 0;
+static const char *trace_src = NULL;   // arquivo já carregado (rodadas seguintes só rebobinam)
+
+// parada das threads: espera com prazo, acordada por loadgen_stop
+static pthread_mutex_t lg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t lg_cond;
+static int lg_running = 0;
+// as threads ficam entre rodadas (estacionadas); lg_thr[i] roda o produtor i
+static park_t lg_park = PARK_INITIALIZER;
+static pthread_t lg_thr[LOADGEN_MAX_PRODUCERS];
+
+void loadgen_defaults(loadgen_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->kind = LOADGEN_CONSTANT;
+    cfg->interval_ms = 5000;
+    cfg->timeout_ms = 30000;
+    cfg->producers = 1;
+    cfg->burst_on_ms = 5000;
+    cfg->burst_off_ms = 15000;
+    cfg->seed = 1;
+}
+
+// =====================================================
+//  Parsing
+// =====================================================
+static const char *kind_names[] = { "constant", "poisson", "bursty", "trace" };
+
+const char* loadgen_kind_name(loadgen_kind_t kind) {
+    return (kind >= LOADGEN_CONSTANT && kind <= LOADGEN_TRACE) ? kind_names[kind] : "?";
+}
+
+int loadgen_parse_kind(const char *name, loadgen_kind_t *out) {
+    for (int i = 0; i <= LOADGEN_TRACE; ++i) {
+        if (strcmp(name, kind_names[i]) == 0) { *out = (loadgen_kind_t)i; return 0; }
+    }
+    return -1;
+}
+
+int loadgen_parse_mix(const char *spec, int mix[3]) {
+    int f, b, s;
+    if (sscanf(spec, "%d:%d:%d", &f, &b, &s) != 3) return -1;
+    if (f < 0 || b < 0 || s < 0 || f + b + s == 0) return -1;
+    mix[0] = f; mix[1] = b; mix[2] = s;
+    return 0;
+}
+
+int loadgen_parse_burst(const char *spec, int *on_ms, int *off_ms) {
+    int on, off;
+    if (sscanf(spec, "%d:%d", &on, &off) != 2 || on <= 0 || off < 0) return -1;
+    *on_ms = on; *off_ms = off;
+    return 0;
+}
+
+static int parse_type(const char *tok) {
+    switch (tok[0]) {
+        case 'F': case 'f': return MOD_FIOS;
+        case 'B': case 'b': return MOD_BOTAO;
+        case 'S': case 's': return MOD_SENHAS;
+        default: return -1; // '*' ou desconhecido: sorteio
+    }
+}
+
+static int cmp_entry(const void *a, const void *b) {
+    long long x = ((const trace_entry_t*)a)->at_ms, y = ((const trace_entry_t*)b)->at_ms;
+    return (x > y) - (x < y);
+}
+
+static int trace_load(const char *path) {
+    if (trace && path == trace_src) return 0;
+    trace_src = NULL;
+    free(trace);
+    trace = NULL;
+    trace_len = 0;
+    FILE *f = path ? fopen(path, "r") : NULL;
+    if (!f) return -1;
+
+    int cap = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        long long at; char tok[32]; int tmo = 0;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        int got = sscanf(line, "%lld %31s %d", &at, tok, &tmo);
+        if (got < 2 || at < 0) continue;
+        if (trace_len == cap) {
+            int ncap = cap ? cap * 2 : 256;
+            trace_entry_t *n = realloc(trace, (size_t)ncap * sizeof(trace_entry_t));
+            if (!n) break;
+            trace = n; cap = ncap;
+        }
+        trace[trace_len].at_ms = at;
+        trace[trace_len].type = parse_type(tok);
+        trace[trace_len].timeout_ms = got == 3 && tmo > 0 ? tmo * 1000 : 0;
+        trace_len++;
+    }
+    fclose(f);
+    qsort(trace, (size_t)trace_len, sizeof(trace_entry_t), cmp_entry);
+    trace_src = path;
+    return 0;
+}
+
+// =====================================================
+//  Processos de chegada
+// =====================================================
+
+// intervalo médio de um produtor no relógio ativo
+static double producer_mean_ms(const producer_t *p) {
+    double mean = p->gap_ms;
+    if (conf.kind == LOADGEN_BURSTY) {
+        // mesma taxa média, concentrada nas janelas ON
+        mean *= (double)conf.burst_on_ms / (conf.burst_on_ms + conf.burst_off_ms);
+    }
+    return mean;
+}
+
+static double draw_gap(producer_t *p) {
+    if (conf.kind == LOADGEN_CONSTANT) return p->gap_ms;
+    return -producer_mean_ms(p) * log(rng_uniform01(&p->rng));
+}
+
+// instante (relativo ao início) da próxima chegada, ou -1
+static long long arrival_at(const producer_t *p) {
+    switch (conf.kind) {
+        case LOADGEN_TRACE:
+            return p->cursor < trace_len ? trace[p->cursor].at_ms : -1;
+        case LOADGEN_BURSTY: {
+            long long a = (long long)p->active_ms;
+            long long cycle = (long long)conf.burst_on_ms + conf.burst_off_ms;
+            return a / conf.burst_on_ms * cycle + a % conf.burst_on_ms;
+        }
+        default:
+            return (long long)p->active_ms;
+    }
+}
+
+static void advance(producer_t *p) {
+    if (conf.kind == LOADGEN_TRACE) p->cursor += n_prod;
+    else p->active_ms += draw_gap(p);
+}
+
+static int draw_type(producer_t *p) {
+    int total = conf.mix[0] + conf.mix[1] + conf.mix[2];
+    if (total <= 0) return -1;
+    int r = (int)(rng_next32(&p->rng) % (unsigned int)total);
+    for (int t = 0; t < 3; ++t) {
+        if (r < conf.mix[t]) return t;
+        r -= conf.mix[t];
+    }
+    return -1;
+}
+
+int loadgen_configure(const loadgen_config_t *cfg) {
+    conf = *cfg;
+    if (conf.interval_ms < 1) conf.interval_ms = 1;
+    if (conf.producers < 1) conf.producers = 1;
+    if (conf.bombs < 1) conf.bombs = 1;
+    if (conf.bombs > MURAL_MAX_BOMBS) conf.bombs = MURAL_MAX_BOMBS;
+    if (conf.producers * conf.bombs > LOADGEN_MAX_PRODUCERS) conf.producers = LOADGEN_MAX_PRODUCERS / conf.bombs;
+    if (conf.burst_on_ms < 1) conf.burst_on_ms = 1;
+    if (conf.burst_off_ms < 0) conf.burst_off_ms = 0;
+    if (conf.kind == LOADGEN_TRACE && trace_load(conf.trace_path) != 0) return -1;
+
+    n_prod = conf.producers * conf.bombs;
+    start_ms = sim_now_ms();
+    atomic_store(&next_id, 1);
+    atomic_store(&generated, 0);
+    // fluxos de conteúdo de todos os índices: o replay injeta com o
+    // produtor gravado, mesmo que a rodada tenha menos produtores
+    for (int i = 0; i < LOADGEN_MAX_PRODUCERS; ++i)
+        rng_seed(&prod[i].mod_rng, rng_master(), RNG_STREAM_MURAL + (uint64_t)i);
+    for (int i = 0; i < n_prod; ++i) {
+        producer_t *p = &prod[i];
+        // fluxos independentes e reprodutíveis por produtor
+        rng_seed(&p->rng, conf.seed, RNG_STREAM_PRODUCER + (uint64_t)i);
+        p->cursor = i;
+        p->bomb = i % conf.bombs;
+        int interval = conf.bomb_interval_ms[p->bomb] > 0 ? conf.bomb_interval_ms[p->bomb] : conf.interval_ms;
+        p->gap_ms = (double)interval * conf.producers;
+        // constante: produtores da bomba defasados; os demais começam por um sorteio
+        if (conf.kind == LOADGEN_CONSTANT) p->active_ms = (double)interval * (i / conf.bombs);
+        else p->active_ms = conf.kind == LOADGEN_TRACE ? 0 : draw_gap(p);
+    }
+    return 0;
+}
+
+int loadgen_producers(void) { return n_prod; }
+int loadgen_generated(void) { return atomic_load(&generated); }
+
+long long loadgen_next_delay_ms(int producer) {
+    if (producer < 0 || producer >= n_prod) return -1;
+    if (!mural_bomb_open(prod[producer].bomb)) return -1;
+    long long at = arrival_at(&prod[producer]);
+    if (at < 0) return -1;
+    long long d = start_ms + at - sim_now_ms();
+    return d > 0 ? d : 0;
+}
+
+int loadgen_emit(int producer) {
+    if (producer < 0 || producer >= n_prod) return 0;
+    producer_t *p = &prod[producer];
+    int type = -1, timeout_ms = conf.timeout_ms;
+    if (conf.kind == LOADGEN_TRACE) {
+        if (p->cursor >= trace_len) return 0;
+        type = trace[p->cursor].type;
+        if (trace[p->cursor].timeout_ms > 0) timeout_ms = trace[p->cursor].timeout_ms;
+    }
+    if (type < 0) type = draw_type(p);
+    advance(p);
+    return loadgen_inject(producer, atomic_fetch_add(&next_id, 1), type, timeout_ms);
+}
+
+int loadgen_inject(int producer, int id, int type, int timeout_ms) {
+    if (producer < 0 || producer >= LOADGEN_MAX_PRODUCERS) producer = 0;
+    module_t *m = create_module_of_type(id, type, &prod[producer].mod_rng, producer);
+    if (!m) return 0;
+    m->timeout_ms = timeout_ms;
+    m->bomb = producer % conf.bombs;
+    atomic_fetch_add(&generated, 1);
+    log_record(LOG_EV_GEN_CREATED, m->id, -1, -1, m->type);
+    rec_emit(REC_GEN, m->id, producer, timeout_ms, type);
+    mural_push(m);
+    return 1;
+}
+
+// =====================================================
+//  Threads produtoras
+// =====================================================
+// Uma rodada do produtor id (nenhuma, se a rodada tem menos produtores)
+static void producer_round(int id) {
+    LOCK(&lg_mutex);
+    while (lg_running && id < n_prod) {
+        long long d = loadgen_next_delay_ms(id);
+        if (d < 0) break; // trace esgotado
+        if (d > 0) {
+            struct timespec until;
+            sim_abs_timespec(sim_now_ms() + d, &until);
+            COND_TIMEDWAIT(&lg_cond, &lg_mutex, &until);
+            continue;
+        }
+        UNLOCK(&lg_mutex);
+        loadgen_emit(id);
+        LOCK(&lg_mutex);
+    }
+    UNLOCK(&lg_mutex);
+}
+
+static void* producer_fn(void *arg) {
+    int id = (int)(long)arg;
+    do {
+        producer_round(id);
+    } while (park_enter(&lg_park));
+    return NULL;
+}
+
+void loadgen_start(void) {
+    static int cond_ready = 0;
+    if (!cond_ready) { sim_cond_init(&lg_cond); cond_ready = 1; } // espera no relógio monotônico
+    LOCK(&lg_mutex);
+    lg_running = 1;
+    UNLOCK(&lg_mutex);
+    // reaproveita as threads estacionadas e cria só as que faltam
+    int have = park_threads(&lg_park);
+    park_open(&lg_park);
+    int threads = have;
+    for (int i = have; i < n_prod; ++i) {
+        if (park_spawn(&lg_park, &lg_thr[i], producer_fn, (void*)(long)i) != 0) break;
+        threads++;
+    }
+    if (threads > n_prod) threads = n_prod;
+    log_event("[GEN] %d produtor(es), chegadas %s, intervalo medio %d ms",
+              threads, loadgen_kind_name(conf.kind), conf.interval_ms);
+}
+
+void loadgen_stop(void) {
+    LOCK(&lg_mutex);
+    lg_running = 0;
+    pthread_cond_broadcast(&lg_cond);
+    UNLOCK(&lg_mutex);
+    park_close(&lg_park);
+}
+
+void loadgen_exit(void) {
+    if (park_threads(&lg_park) == 0) return;
+    park_exit(&lg_park, lg_thr);
+}
@@ -0,0 +1,68 @@
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include "config.h"
+
+// Gerador de carga: K produtores independentes criam módulos e os
+// empurram no mural segundo um processo de chegada. A taxa configurada
+// é a total (interval_ms é o intervalo médio entre chegadas somando
+// todos os produtores); cada produtor tem o próprio fluxo aleatório.
+// Com várias bombas cada uma tem os seus K produtores (o produtor p serve
+// a bomba p % bombas) e o próprio intervalo médio.
+// Fora da simulação cada produtor é uma thread; no modo --sim o laço de
+// eventos chama loadgen_emit/loadgen_next_delay_ms por produtor.
+
+typedef enum {
+    LOADGEN_CONSTANT = 0,   // período fixo (o gerador original)
+    LOADGEN_POISSON,        // intervalos exponenciais
+    LOADGEN_BURSTY,         // Poisson só nas janelas ON, silêncio nas OFF
+    LOADGEN_TRACE           // instantes e tipos lidos de um arquivo
+} loadgen_kind_t;
+
+#define LOADGEN_MAX_PRODUCERS 64
+
+typedef struct {
+    loadgen_kind_t kind;
+    int interval_ms;        // intervalo médio entre chegadas (total)
+    int timeout_ms;         // prazo dado a cada módulo (trace pode sobrepor)
+    int producers;          // K threads produtoras por bomba (>= 1)
+    int bombs;              // bombas alimentadas (0 ou 1 = modo clássico)
+    int bomb_interval_ms[MURAL_MAX_BOMBS]; // por bomba; 0 = interval_ms
+    int burst_on_ms;        // bursty: duração das janelas ON / OFF
+    int burst_off_ms;
+    int mix[3];             // pesos FIOS:BOTAO:SENHAS; tudo 0 = sorteio do mural
+    unsigned int seed;      // fluxos dos produtores derivam desta semente
+    const char *trace_path; // LOADGEN_TRACE: "<ms> <F|B|S|*> [timeout_s]" por linha
+} loadgen_config_t;
+
+void loadgen_defaults(loadgen_config_t *cfg);
+
+// Parsing dos argumentos de linha de comando (0 ok, -1 inválido)
+int loadgen_parse_kind(const char *name, loadgen_kind_t *out);
+int loadgen_parse_mix(const char *spec, int mix[3]);          // "F:B:S"
+int loadgen_parse_burst(const char *spec, int *on_ms, int *off_ms); // "ON:OFF"
+const char* loadgen_kind_name(loadgen_kind_t kind);
+
+// Prepara uma rodada: zera os produtores e, para trace, carrega o arquivo.
+// O relógio da rodada começa aqui (sim_now_ms). Retorna 0 ou -1.
+int loadgen_configure(const loadgen_config_t *cfg);
+int loadgen_producers(void);
+
+// Um produtor: espera até a próxima chegada (-1 = acabou: trace esgotado
+// ou bomba encerrada) e cria o módulo dela. Usado pelas threads e pelo
+// laço da simulação.
+long long loadgen_next_delay_ms(int producer);
+int loadgen_emit(int producer);     // 1 se criou o módulo
+
+// Cria e publica um módulo já decidido (id, tipo pedido, prazo), como se
+// viesse do produtor; usado pelo replay de uma gravação.
+int loadgen_inject(int producer, int id, int type, int timeout_ms);
+
+// Threads produtoras
+void loadgen_start(void);
+void loadgen_stop(void);    // as threads estacionam até o próximo loadgen_start
+void loadgen_exit(void);    // fim do programa: encerra as threads
+
+int loadgen_generated(void);        // módulos criados desde loadgen_configure
+
+#endif // LOADGEN_H
@@ -0,0 +1,240 @@
+#define _POSIX_C_SOURCE 200809L
+#include "lockprof.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#ifdef KSNE_LOCKPROF
+
+// =====================================================
+//  Tabela de pontos de aquisição
+// =====================================================
+// Endereçamento aberto por (arquivo, linha). Um slot é reivindicado uma
+// vez (VAZIO -> PREENCHENDO -> PRONTO) e nunca mais muda de dono, então
+// a busca não precisa de lock.
+#define LOCKPROF_MAX_SITES 512          // potência de 2
+#define LOCKPROF_MAX_HELD 64            // locks seguros ao mesmo tempo por thread
+
+enum { SITE_EMPTY = 0, SITE_FILLING, SITE_READY };
+
+typedef struct {
+    atomic_int state;
+    const char *file;
+    int line;
+    atomic_ullong acquisitions;
+    atomic_ullong contended;
+    atomic_ullong wait_ns;
+    atomic_ullong max_wait_ns;
+    atomic_ullong hold_ns;
+    atomic_ullong max_hold_ns;
+} lock_site_t;
+
+static lock_site_t sites[LOCKPROF_MAX_SITES];
+static atomic_int sites_dropped;        // tabela cheia
+
+// Locks seguros pela thread: o UNLOCK encontra aqui o instante e o ponto
+// da aquisição (a ordem de liberação não precisa ser a inversa)
+typedef struct {
+    pthread_mutex_t *m;
+    lock_site_t *site;
+    long long since_ns;
+} held_t;
+
+static _Thread_local held_t held[LOCKPROF_MAX_HELD];
+static _Thread_local int n_held = 0;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);   // contenção é tempo real, mesmo no --sim
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void store_max(atomic_ullong *slot, unsigned long long v) {
+    unsigned long long old = atomic_load_explicit(slot, memory_order_relaxed);
+    while (v > old && !atomic_compare_exchange_weak_explicit(slot, &old, v,
+                memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+static int same_site(lock_site_t *s, const char *file, int line) {
+    return s->line == line && (s->file == file || strcmp(s->file, file) == 0);
+}
+
+static lock_site_t* site_of(const char *file, int line) {
+    uintptr_t h = ((uintptr_t)file >> 3) * 31u + (uintptr_t)line * 2654435761u;
+    for (int probe = 0; probe < LOCKPROF_MAX_SITES; ++probe) {
+        lock_site_t *s = &sites[(h + (uintptr_t)probe) & (LOCKPROF_MAX_SITES - 1)];
+        int st = atomic_load_explicit(&s->state, memory_order_acquire);
+        if (st == SITE_EMPTY) {
+            int expected = SITE_EMPTY;
+            if (atomic_compare_exchange_strong(&s->state, &expected, SITE_FILLING)) {
+                s->file = file;
+                s->line = line;
+                atomic_store_explicit(&s->state, SITE_READY, memory_order_release);
+                return s;
+            }
+            st = expected;
+        }
+        // outro thread está preenchendo este slot: espera publicar
+        while (st == SITE_FILLING) st = atomic_load_explicit(&s->state, memory_order_acquire);
+        if (same_site(s, file, line)) return s;
+    }
+    atomic_fetch_add(&sites_dropped, 1);
+    return NULL;
+}
+
+static void held_push(pthread_mutex_t *m, lock_site_t *site, long long t) {
+    if (n_held < LOCKPROF_MAX_HELD) held[n_held++] = (held_t){ m, site, t };
+}
+
+static void held_pop(pthread_mutex_t *m) {
+    for (int i = n_held - 1; i >= 0; --i) {
+        if (held[i].m != m) continue;
+        lock_site_t *s = held[i].site;
+        if (s) {
+            unsigned long long d = (unsigned long long)(now_ns() - held[i].since_ns);
+            atomic_fetch_add_explicit(&s->hold_ns, d, memory_order_relaxed);
+            store_max(&s->max_hold_ns, d);
+        }
+        held[i] = held[--n_held];
+        return;
+    }
+}
+
+static void note_acquired(pthread_mutex_t *m, lock_site_t *s, long long waited_ns, int contended) {
+    if (s) {
+        atomic_fetch_add_explicit(&s->acquisitions, 1, memory_order_relaxed);
+        if (contended) {
+            atomic_fetch_add_explicit(&s->contended, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&s->wait_ns, (unsigned long long)waited_ns, memory_order_relaxed);
+            store_max(&s->max_wait_ns, (unsigned long long)waited_ns);
+        }
+    }
+    held_push(m, s, now_ns());
+}
+
+// =====================================================
+//  Wrappers
+// =====================================================
+int lockprof_lock(pthread_mutex_t *m, const char *file, int line) {
+    lock_site_t *s = site_of(file, line);
+    // caminho livre: trylock não mede nada
+    if (pthread_mutex_trylock(m) == 0) {
+        note_acquired(m, s, 0, 0);
+        return 0;
+    }
+    long long t0 = now_ns();
+    int rc = pthread_mutex_lock(m);
+    if (rc == 0) note_acquired(m, s, now_ns() - t0, 1);
+    return rc;
+}
+
+int lockprof_trylock(pthread_mutex_t *m, const char *file, int line) {
+    int rc = pthread_mutex_trylock(m);
+    if (rc == 0) note_acquired(m, site_of(file, line), 0, 0);
+    return rc;
+}
+
+int lockprof_unlock(pthread_mutex_t *m) {
+    held_pop(m);
+    return pthread_mutex_unlock(m);
+}
+
+int lockprof_cond_wait(pthread_cond_t *c, pthread_mutex_t *m, const char *file, int line) {
+    held_pop(m);
+    int rc = pthread_cond_wait(c, m);
+    held_push(m, site_of(file, line), now_ns());
+    return rc;
+}
+
+int lockprof_cond_timedwait(pthread_cond_t *c, pthread_mutex_t *m,
+                            const struct timespec *abstime, const char *file, int line) {
+    held_pop(m);
+    int rc = pthread_cond_timedwait(c, m, abstime);
+    held_push(m, site_of(file, line), now_ns());
+    return rc;
+}
+
+// =====================================================
+//  Relatório
+// =====================================================
+static int cmp_wait_desc(const void *a, const void *b) {
+    unsigned long long x = atomic_load(&(*(lock_site_t* const*)a)->wait_ns);
+    unsigned long long y = atomic_load(&(*(lock_site_t* const*)b)->wait_ns);
+    return (x < y) - (x > y);
+}
+
+int lockprof_enabled(void) { return 1; }
+
+int lockprof_format(char *buf, size_t len) {
+    lock_site_t *order[LOCKPROF_MAX_SITES];
+    int n = 0;
+    for (int i = 0; i < LOCKPROF_MAX_SITES; ++i) {
+        if (atomic_load_explicit(&sites[i].state, memory_order_acquire) == SITE_READY &&
+            atomic_load(&sites[i].acquisitions) > 0)
+            order[n++] = &sites[i];
+    }
+    qsort(order, (size_t)n, sizeof(order[0]), cmp_wait_desc);
+
+    size_t off = 0;
+#define PUT(...) do { \
+        int w = snprintf(buf + off, off < len ? len - off : 0, __VA_ARGS__); \
+        if (w > 0) off += (size_t)w; \
+    } while (0)
+    PUT("# contencao de locks (ordem: espera total)\n");
+    PUT("# %-28s %10s %9s %11s %11s %11s %11s\n", "local", "aquisicoes", "contend%",
+        "espera_ms", "esp_max_us", "posse_ms", "pos_max_us");
+    for (int i = 0; i < n; ++i) {
+        lock_site_t *s = order[i];
+        const char *base = strrchr(s->file, '/');
+        char where[64];
+        snprintf(where, sizeof(where), "%s:%d", base ? base + 1 : s->file, s->line);
+        unsigned long long acq = atomic_load(&s->acquisitions);
+        unsigned long long con = atomic_load(&s->contended);
+        PUT("# %-28s %10llu %8.2f%% %11.3f %11.1f %11.3f %11.1f\n", where, acq,
+            acq ? 100.0 * (double)con / (double)acq : 0.0,
+            (double)atomic_load(&s->wait_ns) / 1e6, (double)atomic_load(&s->max_wait_ns) / 1e3,
+            (double)atomic_load(&s->hold_ns) / 1e6, (double)atomic_load(&s->max_hold_ns) / 1e3);
+    }
+    int dropped = atomic_load(&sites_dropped);
+    if (dropped) PUT("# %d aquisicoes fora da tabela (LOCKPROF_MAX_SITES)\n", dropped);
+#undef PUT
+    return (int)(off < len ? off : (len ? len - 1 : 0));
+}
+
+void lockprof_reset(void) {
+    for (int i = 0; i < LOCKPROF_MAX_SITES; ++i) {
+        atomic_store(&sites[i].acquisitions, 0);
+        atomic_store(&sites[i].contended, 0);
+        atomic_store(&sites[i].wait_ns, 0);
+        atomic_store(&sites[i].max_wait_ns, 0);
+        atomic_store(&sites[i].hold_ns, 0);
+        atomic_store(&sites[i].max_hold_ns, 0);
+    }
+    atomic_store(&sites_dropped, 0);
+}
+
+#else // !KSNE_LOCKPROF
+
+int lockprof_enabled(void) { return 0; }
+
+int lockprof_format(char *buf, size_t len) {
+    if (len) buf[0] = '\0';
+    return 0;
+}
+
+void lockprof_reset(void) {}
+
+#endif // KSNE_LOCKPROF
+
+#define LOCKPROF_REPORT_MAX (64 * 1024)
+
+void lockprof_report(FILE *out) {
+    if (!lockprof_enabled()) return;
+    char *text = malloc(LOCKPROF_REPORT_MAX);
+    if (!text) return;
+    int n = lockprof_format(text, LOCKPROF_REPORT_MAX);
+    fwrite(text, 1, (size_t)n, out);
+    free(text);
+}
@@ -0,0 +1,46 @@
+#ifndef LOCKPROF_H
+#define LOCKPROF_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+// Perfil de contenção dos mutexes, opcional em tempo de compilação
+// (make LOCKPROF=1 define KSNE_LOCKPROF). Os módulos usam LOCK/UNLOCK/
+// COND_WAIT no lugar das chamadas pthread; sem a flag as macros são as
+// próprias chamadas e não custam nada.
+//
+// Com a flag, cada ponto de aquisição (__FILE__:__LINE__) acumula:
+// aquisições, quantas encontraram o lock ocupado, tempo de espera e
+// tempo de posse (da aquisição até o UNLOCK correspondente, na mesma
+// thread). Esperas em variável de condição não contam como contenção:
+// a posse termina ao dormir e recomeça, no ponto do COND_WAIT, ao acordar.
+
+#ifdef KSNE_LOCKPROF
+int lockprof_lock(pthread_mutex_t *m, const char *file, int line);
+int lockprof_trylock(pthread_mutex_t *m, const char *file, int line);
+int lockprof_unlock(pthread_mutex_t *m);
+int lockprof_cond_wait(pthread_cond_t *c, pthread_mutex_t *m, const char *file, int line);
+int lockprof_cond_timedwait(pthread_cond_t *c, pthread_mutex_t *m,
+                            const struct timespec *abstime, const char *file, int line);
+
+#define LOCK(m)                  lockprof_lock((m), __FILE__, __LINE__)
+#define TRYLOCK(m)               lockprof_trylock((m), __FILE__, __LINE__)
+#define UNLOCK(m)                lockprof_unlock(m)
+#define COND_WAIT(c, m)          lockprof_cond_wait((c), (m), __FILE__, __LINE__)
+#define COND_TIMEDWAIT(c, m, t)  lockprof_cond_timedwait((c), (m), (t), __FILE__, __LINE__)
+#else
+#define LOCK(m)                  pthread_mutex_lock(m)
+#define TRYLOCK(m)               pthread_mutex_trylock(m)
+#define UNLOCK(m)                pthread_mutex_unlock(m)
+#define COND_WAIT(c, m)          pthread_cond_wait((c), (m))
+#define COND_TIMEDWAIT(c, m, t)  pthread_cond_timedwait((c), (m), (t))
+#endif
+
+int lockprof_enabled(void);                  // 1 se compilado com KSNE_LOCKPROF
+int lockprof_format(char *buf, size_t len);  // tabela ordenada por espera total
+void lockprof_report(FILE *out);             // relatório de encerramento
+void lockprof_reset(void);
+
+#endif // LOCKPROF_H
@@ -4,7 +4,6 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
-#include <semaphore.h>
 #include <time.h>
 #include <ctype.h>
 #include <string.h>
@@ -14,6 +13,14 @@
 #include "tedax.h"
 #include "ui.h"
 #include "coordinator.h"
+#include "sim.h"
+#include "loadgen.h"
+#include "metrics.h"
+#include "lockprof.h"
+#include "recorder.h"
+#include "telemetry.h"
+#include "rng.h"
+#include "halt.h"
 
 // Configurações globais
 static int runtime_num_tedax = NUM_TEDAX;
@@ -22,10 +29,23 @@ static int runtime_module_gen_interval_ms = MODULE_GEN_INTERVAL_MS;
 static int runtime_game_duration_sec = GAME_DURATION_SEC;
 static int runtime_module_timeout_sec = MODULE_TIMEOUT_SEC;
 
-static pthread_t gen_thread;
-static pthread_t watcher_thread;
-static volatile int running = 1;
-static sem_t benches_sem;
+static int crew_override = 0;      // --tedax / --benches: cenários de tripulação grande
+static int bench_override = 0;
+static int bot_interval_ms = 0;   // headless: 0 = piloto automático (despacha a cada evento)
+
+// Replay de uma gravação do jogo com threads: comandos gravados no lugar do bot
+static int replay_live = 0;
+static int replay_autopilot = 0;
+
+// Carga: processo de chegada, mix e produtores vêm da linha de comando;
+// intervalo e prazo vêm da dificuldade (--gen-interval sobrepõe o intervalo)
+static loadgen_config_t load_cfg;
+static int gen_interval_override = 0;
+
+// Multi-bomba (--bombs N, --bomb PESO[:SEG[:INTERVALO_MS]] repetido);
+// n_bombs = 0: uma bomba só, com o timer e a carga da dificuldade
+static mural_bomb_cfg_t bomb_cfg[MURAL_MAX_BOMBS];
+static int n_bombs = 0;
 
 static void apply_difficulty_preset(int choice) {
     switch (choice) {
@@ -56,48 +76,474 @@ static void apply_difficulty_preset(int choice) {
             break;
         default: break;
     }
+    if (crew_override > 0) runtime_num_tedax = crew_override;
+    if (bench_override > 0) runtime_num_benches = bench_override;
 }
 
-static void* generator_fn(void *arg) {
-    (void)arg; int next_id = 1; srand((unsigned int)time(NULL));
-    while (running) {
-        module_t *m = create_module(next_id++);
-        if (m) {
-            m->timeout_secs = runtime_module_timeout_sec;
-            log_event("[GEN] M%d gerado (tipo %d)", m->id, m->type);
-            mural_push(m);
-        }
-        struct timespec ts;
-        ts.tv_sec = runtime_module_gen_interval_ms / 1000;
-        ts.tv_nsec = (runtime_module_gen_interval_ms % 1000) * 1000000;
-        nanosleep(&ts, NULL);
+// Prepara o gerador de carga para a rodada que está começando
+static int configure_load(unsigned int seed) {
+    load_cfg.interval_ms = gen_interval_override > 0 ? gen_interval_override : runtime_module_gen_interval_ms;
+    load_cfg.timeout_ms = runtime_module_timeout_sec * 1000;
+    load_cfg.seed = seed;
+    load_cfg.bombs = n_bombs;
+    for (int b = 0; b < MURAL_MAX_BOMBS; ++b) load_cfg.bomb_interval_ms[b] = bomb_cfg[b].gen_interval_ms;
+    if (loadgen_configure(&load_cfg) != 0) {
+        fprintf(stderr, "nao foi possivel ler o trace '%s'\n", load_cfg.trace_path ? load_cfg.trace_path : "");
+        return -1;
     }
-    return NULL;
+    return 0;
+}
+
+// Garantir que o numero de bancadas e tedax nao seja igual
+static void adjust_bench_count(void) {
+    if (runtime_num_benches == runtime_num_tedax) {
+        log_event("[SYSTEM] Ajustando numero de bancadas para evitar igualdade com TEDAX (%d)", runtime_num_tedax);
+        runtime_num_benches = runtime_num_benches + 1;
+    }
+}
+
+// Fim de uma rodada do jogo: cada parada acorda as threads do módulo pelo
+// próprio condvar (ou pipe, na UI) e espera que estacionem; a próxima
+// rodada as libera sem criar threads. Nada aqui dorme por tempo fixo,
+// então a volta ao menu leva milissegundos; o tempo de cada etapa vai
+// para o log e o total para o histograma ksne_teardown_us. Com linger,
+// o tabuleiro já parado fica na tela (ui_linger) antes de a UI parar;
+// essa espera não entra na medida. A UI para antes de o pool ser
+// destruído: o painel lê os TEDAX e as bancadas até a última tela.
+static void teardown_round(int linger) {
+    long long t0 = sim_now_ns();
+    loadgen_stop();
+    long long t1 = sim_now_ns();
+    mural_expiry_stop();
+    long long t2 = sim_now_ns();
+    coord_shutdown();
+    long long t3 = sim_now_ns();
+    tedax_pool_shutdown();    // workers param de pegar tentativas; o estado fica
+    long long t4 = sim_now_ns();
+    if (linger) ui_linger();
+    long long t4b = sim_now_ns();
+    ui_stop();
+    long long t5 = sim_now_ns();
+    tedax_pool_destroy();
+    long long t6 = sim_now_ns();
+    mural_destroy();
+
+    long long total = (t4 - t0) + (t6 - t4b);
+    metrics_record_us(MET_H_TEARDOWN, total / 1000);
+    log_event("[SYSTEM] Encerramento: %.2f ms (carga %.2f, expiracao %.2f, coordenador %.2f, tedax %.2f, UI %.2f)",
+              total / 1e6, (t1 - t0) / 1e6, (t2 - t1) / 1e6, (t3 - t2) / 1e6,
+              ((t4 - t3) + (t6 - t5)) / 1e6, (t5 - t4b) / 1e6);
 }
 
-static void* watcher_fn(void *arg) {
-    (void)arg;
-    while (running) {
-        module_t *cur = mural_peek_list();
-        time_t now = time(NULL);
-        while (cur) {
-            int age = (int)(now - cur->created_at);
-            int left = cur->timeout_secs - age;
-            if (left <= 0) {
-                module_t *expired = mural_pop_by_id(cur->id);
-                if (expired) {
-                    log_event("[WATCHER] M%d TIMEOUT — requeue", expired->id);
-                    mural_requeue(expired);
+// Fim do programa: encerra as threads estacionadas e fecha o terminal
+static void runtime_exit(void) {
+    loadgen_exit();
+    mural_expiry_exit();
+    coord_exit();
+    tedax_pool_exit();
+    ui_exit();
+}
+
+// =====================================================
+//  Modo headless (--headless --sim)
+// =====================================================
+typedef struct {
+    int won;
+    int score;
+    int money;
+    int generated;
+    int explosions;     // estouraram na mão de um tedax
+    int timeouts;       // venceram esperando no mural
+    long long idle_ms;  // tedax ociosos com módulo no mural, somados (tedax-ms)
+    long long virtual_ms;
+    int bombs;
+    mural_bomb_stats_t bomb[MURAL_MAX_BOMBS];
+} sim_result_t;
+
+// Uma partida inteira no relógio virtual. Um "bot" faz o papel do jogador:
+// como piloto automático (auto-assign a cada evento) ou, com --bot-interval,
+// como um jogador que aperta A de tempos em tempos.
+// A semente fixa a carga (módulos gerados) e os sorteios dos tedax, então
+// duas políticas rodando a mesma semente enfrentam a mesma sequência.
+static sim_result_t run_sim_round(int diff_choice, unsigned int seed) {
+    sim_result_t r = {0};
+    long long armed_deadline = 0;
+
+    apply_difficulty_preset(diff_choice);
+    sim_reset();
+    log_reset();
+    rng_set_master(seed);
+    mural_init();
+    mural_setup_bombs(n_bombs, bomb_cfg, runtime_game_duration_sec);
+    adjust_bench_count();
+    tedax_pool_init(runtime_num_tedax, runtime_num_benches);
+    configure_load(seed);
+    rec_round_begin(diff_choice, mural_get_policy(), seed);
+    telemetry_round_begin(diff_choice, mural_policy_name(mural_get_policy()), seed);
+
+    // no replay as chegadas vêm da gravação, por produtor, como vieram do loadgen
+    int replay = rec_replaying();
+    long long start_ms = sim_now_ms();
+    int producers = replay ? rec_replay_producers() : loadgen_producers();
+    for (int p = 0; p < producers; ++p) {
+        long long d = replay ? rec_replay_gen_delay_ms(p) : loadgen_next_delay_ms(p);
+        if (d >= 0) sim_schedule_in(d, SIM_EV_GENERATE, p);
+    }
+    long long game_ms = (long long)runtime_game_duration_sec * 1000;
+    if (replay_live && rec_replay_end_ms() >= 0 && rec_replay_end_ms() < game_ms)
+        game_ms = rec_replay_end_ms(); // o jogador saiu antes do fim
+    sim_schedule_in(game_ms, SIM_EV_GAME_END, 0);
+    // multi-bomba: o laço acorda no instante em que cada timer vence
+    for (int b = 0; mural_bomb_count() > 1 && b < mural_bomb_count(); ++b) {
+        mural_bomb_stats_t st;
+        mural_bomb_stats(b, &st);
+        if (st.deadline_ms) sim_schedule(st.deadline_ms, SIM_EV_BOMB_TIMER, b);
+    }
+    if (replay_live) {
+        long long d = rec_replay_cmd_delay_ms();
+        if (d >= 0) sim_schedule_in(d, SIM_EV_REPLAY_CMD, 0);
+    } else if (bot_interval_ms > 0) {
+        sim_schedule_in(bot_interval_ms, SIM_EV_BOT_PRESS, 0);
+    }
+
+    sim_event_t ev;
+    while (sim_next(&ev)) {
+        telemetry_tick(sim_now_ms());   // amostras dos instantes já vencidos
+        switch (ev.kind) {
+            case SIM_EV_GENERATE: {
+                long long d;
+                if (replay) {
+                    rec_gen_t g;
+                    if (rec_replay_next_gen(ev.arg, &g)) loadgen_inject(g.producer, g.id, g.type, g.timeout_ms);
+                    d = rec_replay_gen_delay_ms(ev.arg);
+                } else {
+                    loadgen_emit(ev.arg);
+                    d = loadgen_next_delay_ms(ev.arg);
                 }
-            }
-            cur = cur->next;
+                if (d >= 0) sim_schedule_in(d, SIM_EV_GENERATE, ev.arg);
+            } break;
+            case SIM_EV_EXPIRE:
+                mural_expire_due(sim_now_ms());
+                break;
+            case SIM_EV_TEDAX_DONE:
+                tedax_sim_complete(ev.arg);
+                break;
+            case SIM_EV_BOT_PRESS:
+                coord_execute_command("A");
+                sim_schedule_in(bot_interval_ms, SIM_EV_BOT_PRESS, 0);
+                break;
+            case SIM_EV_REPLAY_CMD: {
+                char cmd[128];
+                if (rec_replay_next_cmd(cmd, sizeof(cmd))) coord_execute_command(cmd);
+                long long d = rec_replay_cmd_delay_ms();
+                if (d >= 0) sim_schedule_in(d, SIM_EV_REPLAY_CMD, 0);
+            } break;
+            default: break;
         }
-        sleep(1);
+
+        if (replay_live) {
+            // o jogo com threads segue depois da vitória até o laço principal
+            // notar: o replay dele termina quando a rodada gravada acabou
+            if (ev.kind == SIM_EV_GAME_END) break;
+            if (replay_autopilot && mural_count() > 0) coord_autopilot_dispatch();
+        } else if (bot_interval_ms == 0 && mural_count() > 0) {
+            coord_execute_command("A");
+        }
+
+        // o heap de prazos do mural diz quando acordar para o próximo timeout
+        long long dl = mural_next_deadline();
+        if (dl > 0 && dl != armed_deadline) {
+            sim_schedule(dl, SIM_EV_EXPIRE, 0);
+            armed_deadline = dl;
+        }
+
+        mural_check_bomb_timers(sim_now_ms());
+        if (replay_live) continue;
+        // a rodada acaba quando nenhuma bomba segue armada
+        if (mural_bombs_armed() == 0) { r.won = mural_bombs_defused() == mural_bomb_count(); break; }
+    }
+
+    if (replay_live) r.won = mural_bombs_defused() == mural_bomb_count();
+    r.score = mural_get_score();
+    r.money = mural_get_money();
+    r.generated = loadgen_generated();
+    r.explosions = tedax_explosion_count();
+    r.timeouts = mural_expired_total();
+    r.idle_ms = tedax_idle_ms();
+    r.virtual_ms = sim_now_ms() - start_ms;
+    r.bombs = mural_bomb_count();
+    for (int b = 0; b < r.bombs; ++b) mural_bomb_stats(b, &r.bomb[b]);
+    rec_round_end(r.score, r.generated);
+    telemetry_round_end(r.score, r.won);
+
+    tedax_pool_shutdown();
+    tedax_pool_destroy();
+    mural_destroy();
+    return r;
+}
+
+typedef struct {
+    int wins;
+    long long score_sum;
+    long long explosions;
+    long long timeouts;
+    long long idle_ms;
+    int bombs;
+    int bomb_weight[MURAL_MAX_BOMBS];
+    int bomb_defused[MURAL_MAX_BOMBS];
+    long long bomb_served[MURAL_MAX_BOMBS];
+    long long bomb_wait_ms[MURAL_MAX_BOMBS];
+} sim_totals_t;
+
+static const char* bomb_state_name(int state) {
+    return state == BOMB_DEFUSED ? "DESARMADA" : state == BOMB_EXPLODED ? "EXPLODIU" : "ARMADA";
+}
+
+// Multi-bomba: como o pool se dividiu entre as bombas na rodada
+static void print_bombs(const sim_result_t *r, sim_totals_t *t) {
+    t->bombs = r->bombs;
+    for (int b = 0; b < r->bombs; ++b) {
+        const mural_bomb_stats_t *st = &r->bomb[b];
+        t->bomb_weight[b] = st->weight;
+        t->bomb_defused[b] += st->state == BOMB_DEFUSED;
+        t->bomb_served[b] += st->served;
+        t->bomb_wait_ms[b] += st->wait_ms;
+        printf("  bomba %d (peso %d): %s score=%d chegadas=%d despachados=%d espera_media=%.1fs\n",
+               b + 1, st->weight, bomb_state_name(st->state), st->score, st->arrived, st->served,
+               st->served ? st->wait_ms / 1000.0 / st->served : 0.0);
+    }
+}
+
+static sim_totals_t run_policy(mural_policy_t policy, int rounds, int diff_choice,
+                               unsigned int seed, int verbose) {
+    sim_totals_t t = {0};
+    mural_set_policy(policy);
+    for (int i = 0; i < rounds; ++i) {
+        sim_result_t r = run_sim_round(diff_choice, seed + (unsigned int)i);
+        if (verbose) log_dump(stdout); // últimos LOG_LINES eventos da rodada
+        t.wins += r.won;
+        t.score_sum += r.score;
+        t.explosions += r.explosions;
+        t.timeouts += r.timeouts;
+        t.idle_ms += r.idle_ms;
+        printf("rodada %d [%s]: %s score=%d gold=%d modulos=%d explosoes=%d timeouts=%d "
+               "ocioso=%.1f tedax-s tempo_virtual=%.1fs\n",
+               i + 1, mural_policy_name(policy), r.won ? "VITORIA" : "DERROTA", r.score, r.money,
+               r.generated, r.explosions, r.timeouts, r.idle_ms / 1000.0, r.virtual_ms / 1000.0);
+        if (r.bombs > 1) print_bombs(&r, &t);
+    }
+    return t;
+}
+
+// compare = 1 roda FIFO e EDF sobre as mesmas sementes e resume as duas
+static int run_headless(int rounds, int diff_choice, unsigned int seed, int verbose,
+                        mural_policy_t policy, int compare) {
+    sim_enable(1);
+
+    mural_policy_t policies[2] = { policy, MURAL_POLICY_EDF };
+    int npol = 1;
+    if (compare) { policies[0] = MURAL_POLICY_FIFO; npol = 2; }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    sim_totals_t totals[2];
+    for (int p = 0; p < npol; ++p)
+        totals[p] = run_policy(policies[p], rounds, diff_choice, seed, verbose);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    sim_destroy();
+
+    double wall = (double)(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    for (int p = 0; p < npol; ++p) {
+        sim_totals_t *t = &totals[p];
+        printf("resumo [%s]: %d rodadas, %d vitorias (%.1f%%), score medio %.2f, "
+               "%lld explosoes, %lld timeouts, %.1f tedax-s ociosos com fila\n",
+               mural_policy_name(policies[p]), rounds, t->wins,
+               rounds ? 100.0 * t->wins / rounds : 0.0,
+               rounds ? (double)t->score_sum / rounds : 0.0, t->explosions, t->timeouts,
+               t->idle_ms / 1000.0);
+        long long served = 0;
+        for (int b = 0; b < t->bombs; ++b) served += t->bomb_served[b];
+        for (int b = 0; t->bombs > 1 && b < t->bombs; ++b)
+            printf("resumo [%s] bomba %d (peso %d): %d desarmadas (%.1f%%), %lld despachos (%.1f%%), "
+                   "espera media %.1fs\n",
+                   mural_policy_name(policies[p]), b + 1, t->bomb_weight[b], t->bomb_defused[b],
+                   rounds ? 100.0 * t->bomb_defused[b] / rounds : 0.0, t->bomb_served[b],
+                   served ? 100.0 * t->bomb_served[b] / served : 0.0,
+                   t->bomb_served[b] ? t->bomb_wait_ms[b] / 1000.0 / t->bomb_served[b] : 0.0);
+    }
+    int total_rounds = rounds * npol;
+    printf("tempo: %.3fs reais (%.0f rodadas/min)\n", wall,
+           wall > 0 ? total_rounds * 60.0 / wall : 0.0);
+    return 0;
+}
+
+// Roda de novo, no relógio virtual, cada rodada inteira de uma gravação
+// e confere os eventos produzidos com os gravados
+static int run_replay(const char *path, int verbose) {
+    rec_config_t cfg;
+    if (rec_replay_open(path, &cfg) != 0) return 2;
+    crew_override = cfg.tedax;
+    bench_override = cfg.benches;
+    bot_interval_ms = cfg.bot_interval_ms;
+    replay_live = cfg.live;
+    replay_autopilot = cfg.autopilot;
+    n_bombs = cfg.bombs;
+    for (int b = 0; b < MURAL_MAX_BOMBS; ++b) {
+        bomb_cfg[b].weight = cfg.bomb_weight[b];
+        bomb_cfg[b].duration_sec = cfg.bomb_duration_sec[b];
+        bomb_cfg[b].gen_interval_ms = cfg.bomb_gen_interval_ms[b];
     }
-    return NULL;
+    sim_enable(1);
+
+    int rounds = rec_replay_rounds(), same = 0;
+    for (int i = 0; i < rounds; ++i) {
+        rec_round_info_t info;
+        rec_replay_select(i, &info);
+        mural_set_policy((mural_policy_t)info.policy);
+        sim_result_t r = run_sim_round(info.difficulty, info.seed);
+        if (verbose) log_dump(stdout);
+        char why[320];
+        int ok = rec_replay_verify(why, sizeof(why));
+        same += ok;
+        printf("replay %d [%s]: %s score=%d modulos=%d explosoes=%d timeouts=%d -> %s: %s%s\n",
+               i + 1, mural_policy_name((mural_policy_t)info.policy), r.won ? "VITORIA" : "DERROTA",
+               r.score, r.generated, r.explosions, r.timeouts, ok ? "IDENTICO" : "DIVERGE", why,
+               info.complete ? "" : " (rodada incompleta na gravacao)");
+    }
+    sim_destroy();
+    rec_replay_close();
+    printf("replay: %d/%d rodadas identicas (%s)\n", same, rounds, cfg.live ? "jogo" : "headless");
+    return same == rounds ? 0 : 1;
 }
 
-int main(void) {
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "uso: %s [--policy fifo|edf] [--autopilot] [--tedax N] [--benches N] [--workers N] [--seed S]\n"
+            "        [--linger MS]\n"
+            "bombas: [--bombs N] [--bomb PESO[:SEG[:INTERVALO_MS]]]... (ate %d, pool compartilhado)\n"
+            "     %s --headless --sim [--rounds N] [--difficulty 1-4] [--seed S]\n"
+            "        [--policy fifo|edf|compare] [--bot-interval MS] [--verbose]\n"
+            "carga: [--arrival constant|poisson|bursty|trace] [--trace ARQ] [--burst ON:OFF]\n"
+            "       [--mix F:B:S] [--producers K] [--gen-interval MS]\n"
+            "metricas: [--metrics-sock PATH] [--metrics-file PATH] [--metrics-interval MS]\n"
+            "telemetria: [--telemetry ARQ.jsonl] [--telemetry-interval MS]\n"
+            "gravacao: [--record ARQ]   |   %s --replay ARQ [--verbose]\n", prog, MURAL_MAX_BOMBS, prog, prog);
+}
+
+int main(int argc, char **argv) {
+    int headless = 0, sim = 0, rounds = 1, diff = 2, verbose = 0, compare = 0, autopilot = 0;
+    const char *metrics_sock = NULL, *metrics_file = NULL;
+    const char *record_path = NULL, *replay_path = NULL, *telemetry_path = NULL;
+    int metrics_interval_ms = 1000, telemetry_interval_ms = 1000;
+    mural_policy_t policy = MURAL_POLICY_FIFO;
+    unsigned int seed = (unsigned int)time(NULL);
+    int seed_given = 0, games = 0, bomb_specs = 0;
+    loadgen_defaults(&load_cfg);
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) headless = 1;
+        else if (strcmp(argv[i], "--sim") == 0) sim = 1;
+        else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) rounds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc) diff = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--verbose") == 0) verbose = 1;
+        else if (strcmp(argv[i], "--autopilot") == 0) autopilot = 1;
+        else if (strcmp(argv[i], "--tedax") == 0 && i + 1 < argc) crew_override = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--benches") == 0 && i + 1 < argc) bench_override = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) tedax_set_workers(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--bot-interval") == 0 && i + 1 < argc) bot_interval_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--linger") == 0 && i + 1 < argc) ui_set_linger_ms(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--bombs") == 0 && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            if (n < 1 || n > MURAL_MAX_BOMBS) { usage(argv[0]); return 2; }
+            if (n > n_bombs) n_bombs = n;
+        }
+        else if (strcmp(argv[i], "--bomb") == 0 && i + 1 < argc) {
+            if (bomb_specs == MURAL_MAX_BOMBS ||
+                mural_parse_bomb(argv[++i], &bomb_cfg[bomb_specs]) != 0) { usage(argv[0]); return 2; }
+            if (++bomb_specs > n_bombs) n_bombs = bomb_specs;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+            seed_given = 1;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) record_path = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replay_path = argv[++i];
+        else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) telemetry_path = argv[++i];
+        else if (strcmp(argv[i], "--telemetry-interval") == 0 && i + 1 < argc) telemetry_interval_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--metrics-sock") == 0 && i + 1 < argc) metrics_sock = argv[++i];
+        else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) metrics_file = argv[++i];
+        else if (strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc) metrics_interval_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--producers") == 0 && i + 1 < argc) load_cfg.producers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--gen-interval") == 0 && i + 1 < argc) gen_interval_override = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) load_cfg.trace_path = argv[++i];
+        else if (strcmp(argv[i], "--arrival") == 0 && i + 1 < argc) {
+            if (loadgen_parse_kind(argv[++i], &load_cfg.kind) != 0) { usage(argv[0]); return 2; }
+        }
+        else if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            if (loadgen_parse_mix(argv[++i], load_cfg.mix) != 0) { usage(argv[0]); return 2; }
+        }
+        else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) {
+            if (loadgen_parse_burst(argv[++i], &load_cfg.burst_on_ms, &load_cfg.burst_off_ms) != 0) { usage(argv[0]); return 2; }
+        }
+        else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            if (strcmp(name, "compare") == 0) compare = 1;
+            else if (mural_policy_parse(name, &policy) != 0) { usage(argv[0]); return 2; }
+        }
+        else { usage(argv[0]); return 2; }
+    }
+    if (load_cfg.trace_path && load_cfg.kind != LOADGEN_TRACE) load_cfg.kind = LOADGEN_TRACE;
+    if (load_cfg.kind == LOADGEN_TRACE && !load_cfg.trace_path) {
+        fprintf(stderr, "--arrival trace requer --trace ARQ\n");
+        return 2;
+    }
+    // o trace é lido (e validado) uma vez aqui; cada rodada só o rebobina
+    if (load_cfg.kind == LOADGEN_TRACE && configure_load(seed) != 0) return 2;
+    if (replay_path) {
+        int rc = run_replay(replay_path, verbose);
+        lockprof_report(stderr);
+        return rc;
+    }
+    rec_config_t rec_cfg = { .live = !(headless || sim), .autopilot = autopilot,
+                             .bot_interval_ms = bot_interval_ms, .tedax = crew_override,
+                             .benches = bench_override, .seed = seed, .bombs = n_bombs };
+    for (int b = 0; b < MURAL_MAX_BOMBS; ++b) {
+        rec_cfg.bomb_weight[b] = bomb_cfg[b].weight;
+        rec_cfg.bomb_duration_sec[b] = bomb_cfg[b].duration_sec;
+        rec_cfg.bomb_gen_interval_ms[b] = bomb_cfg[b].gen_interval_ms;
+    }
+    if (record_path && rec_open(record_path, &rec_cfg) != 0) {
+        fprintf(stderr, "nao foi possivel criar a gravacao '%s'\n", record_path);
+        return 2;
+    }
+    if (telemetry_path && telemetry_start(telemetry_path, telemetry_interval_ms) != 0) {
+        fprintf(stderr, "nao foi possivel criar a telemetria '%s'\n", telemetry_path);
+        return 2;
+    }
+    if (headless || sim) {
+        if (!(headless && sim)) {
+            fprintf(stderr, "--headless requer --sim (e vice-versa)\n");
+            return 2;
+        }
+        if (rounds < 1 || diff < 1 || diff > 4 || bot_interval_ms < 0) { usage(argv[0]); return 2; }
+        if (metrics_start(metrics_sock, metrics_file, metrics_interval_ms) != 0) {
+            fprintf(stderr, "nao foi possivel abrir o socket de metricas '%s'\n", metrics_sock);
+            return 2;
+        }
+        int rc = run_headless(rounds, diff, seed, verbose, policy, compare);
+        rec_close();
+        telemetry_stop();
+        metrics_stop();
+        lockprof_report(stderr);
+        return rc;
+    }
+    if (compare) { fprintf(stderr, "--policy compare so existe no modo headless\n"); return 2; }
+    mural_set_policy(policy);
+    coord_set_autopilot(autopilot);
+    if (metrics_start(metrics_sock, metrics_file, metrics_interval_ms) != 0) {
+        fprintf(stderr, "nao foi possivel abrir o socket de metricas '%s'\n", metrics_sock);
+        return 2;
+    }
+
     show_start_screen();
 
     // Loop Principal da Aplicação
@@ -115,60 +561,52 @@ int main(void) {
         }
 
         // --- PREPARAÇÃO DO JOGO ---
+        // --seed fixa a semente mestre (partidas seguintes: seed + 1, + 2...)
+        unsigned int round_seed = seed_given ? seed + (unsigned int)games : (unsigned int)time(NULL);
+        games++;
+        rng_set_master(round_seed);
         apply_difficulty_preset(diff_choice);
         mural_init();
-        mural_setup_timer(runtime_game_duration_sec);
+        mural_setup_bombs(n_bombs, bomb_cfg, runtime_game_duration_sec);
 
-        // Garantir que o numero de bancadas e tedax nao seja igual
-        if (runtime_num_benches == runtime_num_tedax) {
-            log_event("[SYSTEM] Ajustando numero de bancadas para evitar igualdade com TEDAX (%d)", runtime_num_tedax);
-            runtime_num_benches = runtime_num_benches + 1;
-        }
-        if (sem_init(&benches_sem, 0, (unsigned int)runtime_num_benches) != 0) return 1;
+        adjust_bench_count();
 
-        running = 1; // Reset da flag global
+        halt_reset();
+        if (coord_start() != 0) { runtime_exit(); return 1; }
+        tedax_pool_init(runtime_num_tedax, runtime_num_benches);
+        // a UI só sobe com o pool montado: o painel lê pool e bancadas
         ui_start();
-        if (coord_start() != 0) { ui_stop(); sem_destroy(&benches_sem); return 1; }
-        tedax_pool_init(runtime_num_tedax, runtime_num_benches, &benches_sem);
-        pthread_create(&gen_thread, NULL, generator_fn, NULL);
-        pthread_create(&watcher_thread, NULL, watcher_fn, NULL);
+        configure_load(round_seed);
+        rec_round_begin(diff_choice, mural_get_policy(), round_seed);
+        telemetry_round_begin(diff_choice, mural_policy_name(mural_get_policy()), round_seed);
+        // a thread de expiração antes dos produtores: o primeiro push já a encontra
+        mural_expiry_start();
+        loadgen_start();
 
         // --- LOOP DO JOGO ---
-        while (running) {
-            sleep(1);
-            
-            // 1. Verifica tempo
-            int rem = mural_get_remaining_seconds();
-            if (rem <= 0) {
-                log_event("[SYSTEM] TEMPO ESGOTADO!");
-                sleep(2);
-                running = 0;
-            }
-
-            // 2. Verifica CONDIÇÃO DE VITÓRIA (Score >= Meta)
-            if (mural_get_score() >= WIN_SCORE_TARGET) {
-                log_event("[SYSTEM] 🏆 VITORIA! %d MODULOS RESOLVIDOS!", WIN_SCORE_TARGET);
-                sleep(4); // Espera um pouco para ver a mensagem
-                running = 0;
-            }
-
-            // 3. Verifica se o utilizador pressionou Q (UI fechou)
-            if (!is_ui_active()) {
-                running = 0;
-            }
-        }
+        // Dorme até o timer da próxima bomba; o fim da última bomba
+        // (desarmada pelo mural ou explodida aqui) e o Q (UI) acordam o
+        // laço com o motivo, via halt_raise
+        halt_reason_t why;
+        while ((why = halt_wait_until(mural_get_deadline_ms())) == HALT_NONE)
+            mural_check_bomb_timers(sim_now_ms());
+        if (why == HALT_TIME) log_event("[SYSTEM] TEMPO ESGOTADO!");
+        else if (why == HALT_WIN && mural_bomb_count() > 1)
+            log_event("[SYSTEM] 🏆 VITORIA! %d BOMBAS DESARMADAS!", mural_bomb_count());
+        else if (why == HALT_WIN) log_event("[SYSTEM] 🏆 VITORIA! %d MODULOS RESOLVIDOS!", WIN_SCORE_TARGET);
 
         // --- CLEANUP ---
-        pthread_join(gen_thread, NULL);
-        pthread_join(watcher_thread, NULL);
-        coord_shutdown();
-        tedax_pool_shutdown();
-        tedax_pool_destroy();
-        ui_stop(); 
-        mural_destroy();
-        sem_destroy(&benches_sem);
+        rec_round_end(mural_get_score(), loadgen_generated());
+        telemetry_round_end(mural_get_score(), mural_bombs_defused() == mural_bomb_count());
+        log_event("[SYSTEM] Tedax ociosos com fila: %.1f tedax-s", tedax_idle_ms() / 1000.0);
+        teardown_round(why != HALT_QUIT);
     }
 
+    runtime_exit();
+    rec_close();
+    telemetry_stop();
+    metrics_stop();
+    lockprof_report(stderr);
     printf("Obrigado por jogar KEEP SOLVING!\n");
     return 0;
 }
\ No newline at end of file
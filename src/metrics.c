@@ -0,0 +1,278 @@
+#define _POSIX_C_SOURCE 200809L
+#include "metrics.h"
+#include "lockprof.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// =====================================================
+//  Histograma log-linear
+// =====================================================
+// Valores < HIST_SUB caem em buckets exatos; acima disso cada potência
+// de 2 é dividida em HIST_SUB faixas iguais (os HIST_SUB_BITS bits logo
+// abaixo do bit mais alto escolhem a faixa).
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (HIST_SUB + (64 - HIST_SUB_BITS) * HIST_SUB)
+
+typedef struct {
+    atomic_ullong bucket[HIST_BUCKETS];
+    atomic_ullong count;
+    atomic_ullong sum;
+    atomic_ullong max;
+} hist_t;
+
+static hist_t hists[MET_H_COUNT];
+static atomic_ullong counters[MET_C_COUNT];
+
+static const char *hist_names[MET_H_COUNT] = {
+    "ksne_mural_wait_us",
+    "ksne_coord_queue_wait_us",
+    "ksne_bench_wait_us",
+    "ksne_solve_us",
+    "ksne_expiry_detect_us",
+    "ksne_teardown_us",
+};
+
+static const char *counter_names[MET_C_COUNT] = {
+    "ksne_explosions_total",
+    "ksne_requeues_total",
+    "ksne_ai_failures_total",
+    "ksne_dropped_commands_total",
+    "ksne_timeouts_total",
+};
+
+static int bucket_of(unsigned long long v) {
+    if (v < HIST_SUB) return (int)v;
+    int p = 63 - __builtin_clzll(v);
+    int shift = p - HIST_SUB_BITS;
+    return HIST_SUB + shift * HIST_SUB + (int)((v >> shift) & (HIST_SUB - 1));
+}
+
+// maior valor que cai no bucket (o quantil reportado nunca subestima)
+static unsigned long long bucket_high(int idx) {
+    if (idx < HIST_SUB) return (unsigned long long)idx;
+    int shift = (idx - HIST_SUB) / HIST_SUB;
+    unsigned long long sub = (unsigned long long)((idx - HIST_SUB) % HIST_SUB);
+    unsigned long long low = ((unsigned long long)HIST_SUB | sub) << shift;
+    return low + (1ULL << shift) - 1;
+}
+
+void metrics_record_us(metrics_hist_id_t h, long long us) {
+    if (h < 0 || h >= MET_H_COUNT) return;
+    if (us < 0) us = 0;
+    hist_t *hs = &hists[h];
+    unsigned long long v = (unsigned long long)us;
+    atomic_fetch_add_explicit(&hs->bucket[bucket_of(v)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hs->sum, v, memory_order_relaxed);
+    unsigned long long old = atomic_load_explicit(&hs->max, memory_order_relaxed);
+    while (v > old && !atomic_compare_exchange_weak_explicit(&hs->max, &old, v,
+                memory_order_relaxed, memory_order_relaxed)) {}
+    // count por último: quem lê count nunca vê mais amostras que buckets
+    atomic_fetch_add_explicit(&hs->count, 1, memory_order_release);
+}
+
+void metrics_inc(metrics_counter_id_t c) {
+    if (c < 0 || c >= MET_C_COUNT) return;
+    atomic_fetch_add_explicit(&counters[c], 1, memory_order_relaxed);
+}
+
+unsigned long long metrics_count(metrics_hist_id_t h) {
+    return (h >= 0 && h < MET_H_COUNT) ? atomic_load(&hists[h].count) : 0;
+}
+
+unsigned long long metrics_counter(metrics_counter_id_t c) {
+    return (c >= 0 && c < MET_C_COUNT) ? atomic_load(&counters[c]) : 0;
+}
+
+long long metrics_quantile_us(metrics_hist_id_t h, double q) {
+    if (h < 0 || h >= MET_H_COUNT) return 0;
+    hist_t *hs = &hists[h];
+    unsigned long long n = atomic_load_explicit(&hs->count, memory_order_acquire);
+    if (n == 0) return 0;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    unsigned long long rank = (unsigned long long)(q * (double)(n - 1)) + 1;
+    unsigned long long seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; ++i) {
+        seen += atomic_load_explicit(&hs->bucket[i], memory_order_relaxed);
+        if (seen >= rank) {
+            unsigned long long hi = bucket_high(i), mx = atomic_load(&hs->max);
+            return (long long)(hi < mx ? hi : mx);
+        }
+    }
+    return (long long)atomic_load(&hs->max);
+}
+
+void metrics_reset(void) {
+    for (int h = 0; h < MET_H_COUNT; ++h) {
+        for (int i = 0; i < HIST_BUCKETS; ++i) atomic_store(&hists[h].bucket[i], 0);
+        atomic_store(&hists[h].count, 0);
+        atomic_store(&hists[h].sum, 0);
+        atomic_store(&hists[h].max, 0);
+    }
+    for (int c = 0; c < MET_C_COUNT; ++c) atomic_store(&counters[c], 0);
+}
+
+// =====================================================
+//  Texto
+// =====================================================
+static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+#define N_QUANTILES (int)(sizeof(quantiles) / sizeof(quantiles[0]))
+
+int metrics_format(char *buf, size_t len) {
+    size_t n = 0;
+#define PUT(...) do { \
+        int w = snprintf(buf + n, n < len ? len - n : 0, __VA_ARGS__); \
+        if (w > 0) n += (size_t)w; \
+    } while (0)
+    for (int h = 0; h < MET_H_COUNT; ++h) {
+        unsigned long long cnt = metrics_count(h);
+        unsigned long long sum = atomic_load(&hists[h].sum);
+        for (int i = 0; i < N_QUANTILES; ++i)
+            PUT("%s{quantile=\"%g\"} %lld\n", hist_names[h], quantiles[i], metrics_quantile_us(h, quantiles[i]));
+        PUT("%s_max %llu\n", hist_names[h], atomic_load(&hists[h].max));
+        PUT("%s_sum %llu\n", hist_names[h], sum);
+        PUT("%s_count %llu\n", hist_names[h], cnt);
+    }
+    for (int c = 0; c < MET_C_COUNT; ++c)
+        PUT("%s %llu\n", counter_names[c], metrics_counter(c));
+#undef PUT
+    // make LOCKPROF=1: ranking de contenção em linhas de comentário
+    if (n < len) n += (size_t)lockprof_format(buf + n, len - n);
+    return (int)(n < len ? n : (len ? len - 1 : 0));
+}
+
+#define METRICS_TEXT_MAX (64 * 1024)
+
+int metrics_write_file(const char *path) {
+    if (!path) return -1;
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    char *text = malloc(METRICS_TEXT_MAX);
+    if (!text) return -1;
+    int n = metrics_format(text, METRICS_TEXT_MAX);
+    FILE *f = fopen(tmp, "w");
+    if (!f) { free(text); return -1; }
+    size_t w = fwrite(text, 1, (size_t)n, f);
+    free(text);
+    if (fclose(f) != 0 || w != (size_t)n) { remove(tmp); return -1; }
+    // rename é atômico: o leitor nunca vê um arquivo pela metade
+    return rename(tmp, path);
+}
+
+// =====================================================
+//  Exportação (uma thread: socket + arquivo periódico)
+// =====================================================
+static pthread_t exp_thread;
+static int exp_running = 0;
+static int listen_fd = -1;
+static int stop_pipe[2] = { -1, -1 };
+static char sock_path_buf[108];
+static const char *file_path = NULL;
+static int file_interval_ms = 1000;
+
+static char serve_buf[METRICS_TEXT_MAX];   // só a thread exportadora usa
+
+static void serve_one(int fd) {
+    char *text = serve_buf;
+    int n = metrics_format(text, METRICS_TEXT_MAX);
+    for (int off = 0; off < n;) {
+        ssize_t w = write(fd, text + off, (size_t)(n - off));
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        off += (int)w;
+    }
+    close(fd);
+}
+
+static long long mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// dorme em poll: acorda por conexão, pelo pipe de parada ou pelo prazo do arquivo
+static void* exporter_fn(void *arg) {
+    (void)arg;
+    long long next_dump = mono_ms() + file_interval_ms;
+    for (;;) {
+        struct pollfd pf[2];
+        int np = 0;
+        pf[np].fd = stop_pipe[0]; pf[np].events = POLLIN; np++;
+        if (listen_fd >= 0) { pf[np].fd = listen_fd; pf[np].events = POLLIN; np++; }
+        int timeout = -1;
+        if (file_path) {
+            long long d = next_dump - mono_ms();
+            timeout = d > 0 ? (int)d : 0;
+        }
+        int r = poll(pf, (nfds_t)np, timeout);
+        if (r < 0 && errno != EINTR) break;
+        if (r > 0 && pf[0].revents) break;
+        if (r > 0 && np > 1 && (pf[1].revents & POLLIN)) {
+            int c = accept(listen_fd, NULL, NULL);
+            if (c >= 0) serve_one(c);
+        }
+        if (file_path && mono_ms() >= next_dump) {
+            metrics_write_file(file_path);
+            next_dump += file_interval_ms;
+        }
+    }
+    return NULL;
+}
+
+int metrics_start(const char *sock_path, const char *fpath, int interval_ms) {
+    if (exp_running || (!sock_path && !fpath)) return 0;
+    file_path = fpath;
+    file_interval_ms = interval_ms > 0 ? interval_ms : 1000;
+    listen_fd = -1;
+    if (sock_path) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(sock_path) >= sizeof(addr.sun_path)) return -1;
+        strcpy(addr.sun_path, sock_path);
+        snprintf(sock_path_buf, sizeof(sock_path_buf), "%s", sock_path);
+        unlink(sock_path); // sobra de uma execução anterior
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) return -1;
+        if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 8) != 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            return -1;
+        }
+    }
+    if (pipe(stop_pipe) != 0) {
+        if (listen_fd >= 0) { close(listen_fd); unlink(sock_path_buf); listen_fd = -1; }
+        return -1;
+    }
+    if (pthread_create(&exp_thread, NULL, exporter_fn, NULL) != 0) {
+        close(stop_pipe[0]); close(stop_pipe[1]);
+        if (listen_fd >= 0) { close(listen_fd); unlink(sock_path_buf); listen_fd = -1; }
+        return -1;
+    }
+    exp_running = 1;
+    return 0;
+}
+
+void metrics_stop(void) {
+    if (!exp_running) return;
+    char b = 1;
+    ssize_t w = write(stop_pipe[1], &b, 1); // pipe vazio: não falha
+    (void)w;
+    pthread_join(exp_thread, NULL);
+    close(stop_pipe[0]); close(stop_pipe[1]);
+    stop_pipe[0] = stop_pipe[1] = -1;
+    if (listen_fd >= 0) { close(listen_fd); unlink(sock_path_buf); listen_fd = -1; }
+    if (file_path) metrics_write_file(file_path);
+    exp_running = 0;
+}
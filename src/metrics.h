@@ -0,0 +1,48 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+
+// Métricas do processo: histogramas de latência no estilo HDR (buckets
+// log-lineares, ~6% de erro relativo) e contadores monotônicos. Gravar é
+// sem lock e sem alocação; os valores acumulam entre as rodadas.
+// Um leitor local obtém o texto por um socket Unix (uma conexão = um
+// dump) ou por um arquivo reescrito periodicamente.
+
+typedef enum {
+    MET_H_MURAL_WAIT = 0,   // entrada no mural -> atribuição a um tedax
+    MET_H_COORD_QUEUE,      // comando enfileirado -> retirado pelo coordenador
+    MET_H_BENCH_WAIT,       // tedax com módulo -> bancada obtida
+    MET_H_SOLVE,            // duração da tentativa (até sucesso, falha ou explosão)
+    MET_H_EXPIRY_DETECT,    // prazo do módulo -> timeout detectado
+    MET_H_TEARDOWN,         // fim da rodada: parada e join de todas as threads
+    MET_H_COUNT
+} metrics_hist_id_t;
+
+typedef enum {
+    MET_C_EXPLOSIONS = 0,   // módulos que explodiram na mão de um tedax
+    MET_C_REQUEUES,         // módulos devolvidos ao mural
+    MET_C_AI_FAILURES,      // tentativas automáticas que falharam
+    MET_C_DROPPED_CMDS,     // comandos recusados por fila cheia
+    MET_C_TIMEOUTS,         // prazos vencidos no mural
+    MET_C_COUNT
+} metrics_counter_id_t;
+
+// Produtores (qualquer thread). Latências em microssegundos do relógio do jogo.
+void metrics_record_us(metrics_hist_id_t h, long long us);
+void metrics_inc(metrics_counter_id_t c);
+
+// Consulta
+long long metrics_quantile_us(metrics_hist_id_t h, double q);
+unsigned long long metrics_count(metrics_hist_id_t h);
+unsigned long long metrics_counter(metrics_counter_id_t c);
+int metrics_format(char *buf, size_t len);   // texto "nome valor" por linha
+int metrics_write_file(const char *path);    // escreve em path.tmp e renomeia
+void metrics_reset(void);
+
+// Exportação: socket Unix e/ou arquivo a cada interval_ms (NULL desliga).
+// Retorna 0 ou -1 (socket não pôde ser criado).
+int metrics_start(const char *sock_path, const char *file_path, int interval_ms);
+void metrics_stop(void);   // grava o arquivo uma última vez
+
+#endif // METRICS_H
@@ -2,34 +2,253 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <pthread.h>
 #include <time.h>
+#include <stdatomic.h>
 
 #include "mural.h"
+#include "eventlog.h"
 #include "ui.h"
 #include "config.h"
+#include "coordinator.h"
+#include "sim.h"
+#include "slab.h"
+#include "metrics.h"
+#include "lockprof.h"
+#include "recorder.h"
+#include "rng.h"
+#include "park.h"
+#include "halt.h"
 
-// Duas listas: Ativos e Resolvidos
-static module_t *mural_head = NULL;
-static module_t *mural_tail = NULL;
+#define NUM_MODULE_TYPES 3
 
+// =====================================================
+//  Shards dos ativos
+// =====================================================
+// Os ativos ficam repartidos em MURAL_SHARDS shards pelo hash do id; cada
+// shard tem seu lock, sua fila FIFO, seu índice id -> módulo, suas listas
+// por tipo e seu heap de prazos. Um módulo nunca muda de shard (o id é
+// fixo), então re-enfileirar e expirar só tocam um lock.
+// A ordem global de chegada é o seq, tirado de um contador atômico sob o
+// lock do shard: dentro de cada shard a fila fica ordenada por seq, e a
+// cabeça global é a menor cabeça entre os shards.
+// Nenhuma operação segura dois locks de shard ao mesmo tempo, exceto
+// mural_destroy, que os toma em ordem crescente.
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+    module_t *head;
+    module_t *tail;
+    int size;
+    module_t **id_buckets;
+    unsigned int id_nbuckets;            // potência de 2
+    module_t *type_head[NUM_MODULE_TYPES];
+    module_t *type_tail[NUM_MODULE_TYPES];
+    module_t **dl_heap;                  // min-heap por created_ms + timeout_ms
+    int dl_len;
+    int dl_cap;
+    atomic_llong top_deadline;           // prazo do topo do heap (0 = vazio), lido sem lock
+} mural_shard_t;
+
+static mural_shard_t shards[MURAL_SHARDS];
+static int shards_ready = 0;
+static atomic_ullong next_seq;
+static atomic_int active_count;
+// Relógio de espera: anda só enquanto há módulo no mural (active_count > 0);
+// a ociosidade dos tedax é medida nele, não no relógio do jogo
+static pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static long long wait_total_ms = 0;     // espera já encerrada
+static long long wait_since_ms = -1;    // início da espera atual (-1 = mural vazio)
+
+// Resolvidos: lista própria, com lock próprio
+static pthread_mutex_t resolved_lock = PTHREAD_MUTEX_INITIALIZER;
 static module_t *resolved_head = NULL; // Lista de resolvidos
+static module_t *resolved_tail = NULL;
+static int resolved_count = 0;         // nós ainda na lista
+static atomic_int resolved_total;      // resumo: todos os resolvidos da partida
+static atomic_int resolved_by_type[NUM_MODULE_TYPES];
+static int resolved_keep = MURAL_RESOLVED_KEEP;
+
+// Versão do estado visível (fila, resolvidos, score, dinheiro, timer)
+static atomic_ulong mural_ver;
+static _Atomic mural_policy_t dispatch_policy = MURAL_POLICY_FIFO;
+static atomic_int expired_total;   // timeouts vistos pelo vigia na partida
+
+// Pool de módulos da partida (criado em mural_init, liberado em mural_destroy)
+static slab_t *module_slab = NULL;
+
+// Contadores globais: fora de qualquer lock do mural
+static atomic_int global_score;
+static atomic_int global_money = MOEDAS_INICIAL;
+static atomic_llong game_deadline;     // ms no relógio do jogo (0 = sem timer)
+
+// Bombas: contadores próprios (atômicos) e o passe do stride scheduling,
+// que só o despacho em lote mexe (sob sched_lock). n_bombs muda apenas
+// entre rodadas, com as threads estacionadas.
+typedef struct {
+    int weight;
+    atomic_int state;                  // bomb_state_t
+    atomic_int score;
+    atomic_int active;
+    atomic_int arrived;
+    atomic_int served;
+    atomic_llong wait_ns;
+    atomic_llong deadline;
+    unsigned long long pass;
+} bomb_t;
+
+static bomb_t bombs[MURAL_MAX_BOMBS];
+static int n_bombs = 1;
+static atomic_int bombs_armed;
+static atomic_int bombs_defused;
+static pthread_mutex_t sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long long sched_vtime = 0;   // passe da última bomba servida
+
+static void expiry_kick(long long deadline);
+
+static bomb_t* bomb_of(const module_t *m) {
+    return &bombs[m->bomb > 0 && m->bomb < n_bombs ? m->bomb : 0];
+}
+
+static mural_shard_t* shard_of_id(int id) {
+    return &shards[((unsigned int)id * 2654435761u >> 16) % MURAL_SHARDS];
+}
+
+// =====================================================
+//  Snapshot publicado para leitores (UI)
+// =====================================================
+// Três buffers: o atual, um possivelmente preso por um leitor lento e um
+// livre para o escritor. Escritores só incrementam mural_ver; o leitor
+// que encontra o snapshot velho o reconstrói, copiando um shard de cada
+// vez, e os leitores nunca seguram lock enquanto desenham.
+#define SNAP_BUFFERS 3
+static mural_snapshot_t snap_buf[SNAP_BUFFERS];
+static atomic_int snap_readers[SNAP_BUFFERS];
+static atomic_int snap_current;
+static atomic_ulong snap_built_ver;
+static pthread_mutex_t snap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// cópia por shard, fundida por seq na publicação (protegida por snap_lock)
+typedef struct {
+    module_view_t v;
+    unsigned long long seq;
+} snap_item_t;
+static snap_item_t snap_parts[MURAL_SHARDS][MURAL_SNAPSHOT_MAX];
+static int snap_part_n[MURAL_SHARDS];
+
+static void fill_view(module_view_t *v, const module_t *m) {
+    v->id = m->id;
+    v->type = m->type;
+    v->time_required = m->time_required;
+    v->deadline_ms = m->created_ms + m->timeout_ms;
+    v->bomb = m->bomb;
+}
+
+// Requer snap_lock
+static void snapshot_publish(void) {
+    int cur = atomic_load(&snap_current);
+    int next = -1;
+    for (int i = 1; i < SNAP_BUFFERS; ++i) {
+        int cand = (cur + i) % SNAP_BUFFERS;
+        if (atomic_load(&snap_readers[cand]) == 0) { next = cand; break; }
+    }
+    if (next < 0) return; // todos presos: a próxima leitura publica
+
+    // a versão é lida antes da cópia: mudanças durante a cópia forçam outra
+    mural_snapshot_t *s = &snap_buf[next];
+    s->version = atomic_load(&mural_ver);
+    s->active_count = atomic_load(&active_count);
+    for (int i = 0; i < MURAL_SHARDS; ++i) {
+        mural_shard_t *sh = &shards[i];
+        int n = 0;
+        LOCK(&sh->lock);
+        for (module_t *m = sh->head; m && n < MURAL_SNAPSHOT_MAX; m = m->next, ++n) {
+            fill_view(&snap_parts[i][n].v, m);
+            snap_parts[i][n].seq = m->seq;
+        }
+        UNLOCK(&sh->lock);
+        snap_part_n[i] = n;
+    }
+    int pos[MURAL_SHARDS] = {0};
+    s->active_n = 0;
+    while (s->active_n < MURAL_SNAPSHOT_MAX) {
+        int best = -1;
+        for (int i = 0; i < MURAL_SHARDS; ++i) {
+            if (pos[i] == snap_part_n[i]) continue;
+            if (best < 0 || snap_parts[i][pos[i]].seq < snap_parts[best][pos[best]].seq) best = i;
+        }
+        if (best < 0) break;
+        s->active[s->active_n++] = snap_parts[best][pos[best]++].v;
+    }
 
-pthread_mutex_t mural_lock = PTHREAD_MUTEX_INITIALIZER;
-static int mural_size = 0;
-static int global_score = 0;
-static int global_money = MOEDAS_INICIAL;
-static time_t game_deadline = 0; 
+    LOCK(&resolved_lock);
+    s->resolved_total = atomic_load(&resolved_total);
+    s->resolved_n = 0;
+    for (module_t *m = resolved_head; m && s->resolved_n < MURAL_SNAPSHOT_MAX; m = m->next)
+        fill_view(&s->resolved[s->resolved_n++], m);
+    UNLOCK(&resolved_lock);
+
+    s->score = atomic_load(&global_score);
+    s->money = atomic_load(&global_money);
+    s->deadline_ms = atomic_load(&game_deadline);
+    s->bombs = n_bombs;
+    for (int b = 0; b < n_bombs; ++b) mural_bomb_stats(b, &s->bomb[b]);
+    atomic_store(&snap_built_ver, s->version);
+    atomic_store(&snap_current, next);
+}
+
+const mural_snapshot_t* mural_snapshot_acquire(void) {
+    // só um leitor reconstrói; os demais usam o snapshot atual
+    if (atomic_load(&snap_built_ver) != atomic_load(&mural_ver) &&
+        TRYLOCK(&snap_lock) == 0) {
+        if (atomic_load(&snap_built_ver) != atomic_load(&mural_ver)) snapshot_publish();
+        UNLOCK(&snap_lock);
+    }
+    for (;;) {
+        int idx = atomic_load(&snap_current);
+        atomic_fetch_add(&snap_readers[idx], 1);
+        // se o escritor trocou de buffer nesse meio tempo, tenta de novo
+        if (atomic_load(&snap_current) == idx) return &snap_buf[idx];
+        atomic_fetch_sub(&snap_readers[idx], 1);
+    }
+}
+
+void mural_snapshot_release(const mural_snapshot_t *s) {
+    if (!s) return;
+    atomic_fetch_sub(&snap_readers[s - snap_buf], 1);
+}
+
+// Sem lock: só marca a mudança e acorda a UI
+static void mural_changed(void) {
+    atomic_fetch_add(&mural_ver, 1);
+    ui_wake();
+}
+
+unsigned long mural_version(void) { return atomic_load(&mural_ver); }
 
 // =====================================================
 //  Criação de Módulos
 // =====================================================
-module_t* create_module(int id) {
-    module_t *m = calloc(1, sizeof(module_t));
+void module_free(module_t *m) {
+    slab_free(module_slab, m);
+}
+
+// Cada produtor sorteia o conteúdo dos seus módulos no próprio fluxo
+// (rng): a sequência de um produtor não depende dos outros nem da ordem
+// entre as threads; o gravador guarda ou repõe cada valor, na fila do produtor
+static unsigned int draw(rng_t *rng, int producer) {
+    return rec_rng(REC_RNG_MODULE, producer, rng_next32(rng));
+}
+
+module_t* create_module_of_type(int id, int type, rng_t *rng, int producer) {
+    module_t *m = module_slab ? slab_alloc(module_slab) : NULL;
     if (!m) return NULL;
 
     m->id = id;
-    m->type = rand() % 3;
+    m->bomb = 0;
+    m->shard = -1;
+    m->heap_idx = -1;
+    m->type = (type >= 0 && type < NUM_MODULE_TYPES) ? (module_type_t)type : (module_type_t)(draw(rng, producer) % 3);
     // Time required varies by module type (in seconds)
     switch (m->type) {
         case MOD_FIOS:  m->time_required = 8;  break; // fios: rapido
@@ -37,219 +256,859 @@ module_t* create_module(int id) {
         case MOD_SENHAS: m->time_required = 18; break; // senhas: mais longo
         default: m->time_required = 10; break;
     }
-    m->created_at = time(NULL);
-    m->timeout_secs = 20 + rand() % 10;
+    m->created_ms = sim_now_ms();
+    m->timeout_ms = (20 + draw(rng, producer) % 10) * 1000;
     m->instruction[0] = '\0';
 
     switch (m->type) {
         case MOD_FIOS: {
-            int correct = (rand() % 3) + 1;
+            int correct = (draw(rng, producer) % 3) + 1;
             snprintf(m->solution, sizeof(m->solution), "CUT %d", correct);
         } break;
         case MOD_BOTAO: {
             const char *colors[] = {"RED", "BLUE", "GREEN", "YELLOW"};
             const char *actions[] = {"HOLD", "PRESS", "DOUBLE"};
-            int c = rand() % 4;
-            int a = rand() % 3;
+            int c = draw(rng, producer) % 4;
+            int a = draw(rng, producer) % 3;
             snprintf(m->solution, sizeof(m->solution), "%s %s", colors[c], actions[a]);
         } break;
         case MOD_SENHAS: {
             const char *words[] = {"FIRE", "WATER", "EARTH", "WIND", "VOID"};
-            snprintf(m->solution, sizeof(m->solution), "WORD %s", words[rand() % 5]);
+            snprintf(m->solution, sizeof(m->solution), "WORD %s", words[draw(rng, producer) % 5]);
         } break;
     }
     return m;
 }
 
+// =====================================================
+//  Índices de um shard (todos protegidos por sh->lock)
+// =====================================================
+// - lista FIFO duplamente encadeada (remoção O(1) no meio), ordenada por seq
+// - tabela hash id -> módulo, encadeada por hash_next
+// - uma lista intrusiva por module_type_t
+// - heap de prazos
+static unsigned int id_hash(const mural_shard_t *sh, int id) {
+    return ((unsigned int)id * 2654435761u) & (sh->id_nbuckets - 1);
+}
+
+static void id_index_rehash(mural_shard_t *sh, unsigned int nbuckets) {
+    module_t **nb = calloc(nbuckets, sizeof(module_t*));
+    if (!nb) return; // mantém a tabela antiga (só fica mais cheia)
+    module_t **old = sh->id_buckets;
+    unsigned int old_n = sh->id_nbuckets;
+    sh->id_buckets = nb;
+    sh->id_nbuckets = nbuckets;
+    for (unsigned int i = 0; i < old_n; ++i) {
+        module_t *cur = old[i];
+        while (cur) {
+            module_t *n = cur->hash_next;
+            unsigned int h = id_hash(sh, cur->id);
+            cur->hash_next = sh->id_buckets[h];
+            sh->id_buckets[h] = cur;
+            cur = n;
+        }
+    }
+    free(old);
+}
+
+static void id_index_insert(mural_shard_t *sh, module_t *m) {
+    if ((unsigned int)sh->size >= sh->id_nbuckets) id_index_rehash(sh, sh->id_nbuckets ? sh->id_nbuckets * 2 : 16);
+    unsigned int h = id_hash(sh, m->id);
+    m->hash_next = sh->id_buckets[h];
+    sh->id_buckets[h] = m;
+}
+
+static module_t* id_index_find(mural_shard_t *sh, int id) {
+    if (!sh->id_buckets) return NULL;
+    module_t *cur = sh->id_buckets[id_hash(sh, id)];
+    while (cur && cur->id != id) cur = cur->hash_next;
+    return cur;
+}
+
+static void id_index_remove(mural_shard_t *sh, module_t *m) {
+    module_t **pp = &sh->id_buckets[id_hash(sh, m->id)];
+    while (*pp && *pp != m) pp = &(*pp)->hash_next;
+    if (*pp) *pp = m->hash_next;
+    m->hash_next = NULL;
+}
+
+// =====================================================
+//  Heap de prazos (min-heap por created_ms + timeout_ms)
+// =====================================================
+static long long deadline_of(const module_t *m) { return m->created_ms + m->timeout_ms; }
+
+// Mesma ordem serve à expiração e ao despacho EDF: no empate de prazo,
+// o módulo mais rápido de resolver vem primeiro
+static int dl_before(const module_t *a, const module_t *b) {
+    long long da = deadline_of(a), db = deadline_of(b);
+    if (da != db) return da < db;
+    if (a->time_required != b->time_required) return a->time_required < b->time_required;
+    return a->id < b->id;
+}
+
+static void dl_set(mural_shard_t *sh, int i, module_t *m) { sh->dl_heap[i] = m; m->heap_idx = i; }
+
+static void dl_sift_up(mural_shard_t *sh, int i) {
+    module_t *m = sh->dl_heap[i];
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (!dl_before(m, sh->dl_heap[p])) break;
+        dl_set(sh, i, sh->dl_heap[p]);
+        i = p;
+    }
+    dl_set(sh, i, m);
+}
+
+static void dl_sift_down(mural_shard_t *sh, int i) {
+    module_t *m = sh->dl_heap[i];
+    while (1) {
+        int l = 2 * i + 1, r = l + 1, s = i;
+        module_t *best = m;
+        if (l < sh->dl_len && dl_before(sh->dl_heap[l], best)) { s = l; best = sh->dl_heap[l]; }
+        if (r < sh->dl_len && dl_before(sh->dl_heap[r], best)) { s = r; }
+        if (s == i) break;
+        dl_set(sh, i, sh->dl_heap[s]);
+        i = s;
+    }
+    dl_set(sh, i, m);
+}
+
+static void dl_publish_top(mural_shard_t *sh) {
+    atomic_store(&sh->top_deadline, sh->dl_len > 0 ? deadline_of(sh->dl_heap[0]) : 0);
+}
+
+static void dl_insert(mural_shard_t *sh, module_t *m) {
+    if (sh->dl_len == sh->dl_cap) {
+        int ncap = sh->dl_cap ? sh->dl_cap * 2 : 64;
+        module_t **n = realloc(sh->dl_heap, (size_t)ncap * sizeof(module_t*));
+        if (!n) { m->heap_idx = -1; return; }
+        sh->dl_heap = n; sh->dl_cap = ncap;
+    }
+    sh->dl_heap[sh->dl_len] = m;
+    dl_sift_up(sh, sh->dl_len++);
+    // novo prazo mais próximo do shard: talvez a thread de expiração precise recalcular
+    if (m->heap_idx == 0) {
+        dl_publish_top(sh);
+        expiry_kick(deadline_of(m));
+    }
+}
+
+static void dl_remove(mural_shard_t *sh, module_t *m) {
+    int i = m->heap_idx;
+    if (i < 0 || i >= sh->dl_len || sh->dl_heap[i] != m) return;
+    m->heap_idx = -1;
+    module_t *last = sh->dl_heap[--sh->dl_len];
+    if (i != sh->dl_len) {
+        dl_set(sh, i, last);
+        if (i > 0 && dl_before(last, sh->dl_heap[(i - 1) / 2])) dl_sift_up(sh, i);
+        else dl_sift_down(sh, i);
+    }
+    if (i == 0 || sh->dl_len == 0) dl_publish_top(sh);
+}
+
+static int type_index_of(module_type_t t) {
+    return (t >= 0 && t < NUM_MODULE_TYPES) ? (int)t : -1;
+}
+
+// Chamado nas viradas 0 <-> 1 do active_count. O estado é relido sob o
+// lock, então viradas concorrentes em shards diferentes não o invertem
+static void wait_clock_update(void) {
+    LOCK(&wait_lock);
+    long long now = sim_now_ms();
+    if (wait_since_ms >= 0) wait_total_ms += now - wait_since_ms;
+    wait_since_ms = atomic_load(&active_count) > 0 ? now : -1;
+    UNLOCK(&wait_lock);
+}
+
+static void wait_clock_reset(void) {
+    LOCK(&wait_lock);
+    wait_total_ms = 0;
+    wait_since_ms = -1;
+    UNLOCK(&wait_lock);
+}
+
+long long mural_waiting_ms(void) {
+    LOCK(&wait_lock);
+    long long t = wait_total_ms;
+    if (wait_since_ms >= 0) t += sim_now_ms() - wait_since_ms;
+    UNLOCK(&wait_lock);
+    return t;
+}
+
+// Liga ao fim da fila do shard e em todos os índices (sh->lock já adquirido)
+static void link_tail(mural_shard_t *sh, module_t *m) {
+    m->seq = atomic_fetch_add(&next_seq, 1);
+    m->shard = (int)(sh - shards);
+    m->next = NULL; // Garante que não aponta para lixo
+    m->prev = sh->tail;
+    if (!sh->head) { sh->head = sh->tail = m; }
+    else { sh->tail->next = m; sh->tail = m; }
+    id_index_insert(sh, m);
+    sh->size++;
+    if (atomic_fetch_add(&active_count, 1) == 0) wait_clock_update();
+    atomic_fetch_add(&bomb_of(m)->active, 1);
+    m->heap_idx = -1;
+    if (!m->expired) dl_insert(sh, m);
+
+    int t = type_index_of(m->type);
+    m->type_next = NULL;
+    m->type_prev = NULL;
+    if (t >= 0) {
+        m->type_prev = sh->type_tail[t];
+        if (sh->type_tail[t]) sh->type_tail[t]->type_next = m;
+        else sh->type_head[t] = m;
+        sh->type_tail[t] = m;
+    }
+    mural_changed();
+}
+
+// Desliga da fila do shard e de todos os índices (sh->lock já adquirido)
+static void unlink_node(mural_shard_t *sh, module_t *m) {
+    if (m->prev) m->prev->next = m->next;
+    else sh->head = m->next;
+    if (m->next) m->next->prev = m->prev;
+    else sh->tail = m->prev;
+
+    id_index_remove(sh, m);
+    dl_remove(sh, m);
+
+    int t = type_index_of(m->type);
+    if (t >= 0) {
+        if (m->type_prev) m->type_prev->type_next = m->type_next;
+        else sh->type_head[t] = m->type_next;
+        if (m->type_next) m->type_next->type_prev = m->type_prev;
+        else sh->type_tail[t] = m->type_prev;
+    }
+
+    m->next = m->prev = NULL;
+    m->type_next = m->type_prev = NULL;
+    m->shard = -1;
+    sh->size--;
+    if (atomic_fetch_sub(&active_count, 1) == 1) wait_clock_update();
+    atomic_fetch_sub(&bomb_of(m)->active, 1);
+    mural_changed();
+}
+
+static void shard_reset(mural_shard_t *sh) {
+    sh->head = sh->tail = NULL;
+    sh->size = 0;
+    free(sh->id_buckets); sh->id_buckets = NULL; sh->id_nbuckets = 0;
+    free(sh->dl_heap); sh->dl_heap = NULL; sh->dl_len = sh->dl_cap = 0;
+    atomic_store(&sh->top_deadline, 0);
+    for (int i = 0; i < NUM_MODULE_TYPES; ++i) sh->type_head[i] = sh->type_tail[i] = NULL;
+}
+
+// Módulo saiu do mural para ser atribuído: fecha a espera
+static void note_dispatched(const module_t *m) {
+    long long waited = sim_now_ns() - m->enqueued_ns;
+    metrics_record_us(MET_H_MURAL_WAIT, waited / 1000);
+    bomb_t *b = bomb_of(m);
+    atomic_fetch_add(&b->served, 1);
+    atomic_fetch_add(&b->wait_ns, waited);
+}
+
 // =====================================================
 //  Gerenciamento da Fila (ATIVOS)
 // =====================================================
 void mural_push(module_t *m) {
-    pthread_mutex_lock(&mural_lock);
-    m->next = NULL; // Garante que não aponta para lixo
-    if (!mural_head) { mural_head = mural_tail = m; } 
-    else { mural_tail->next = m; mural_tail = m; }
-    mural_size++;
-    log_event("[MURAL] M%d adicionado", m->id);
-    pthread_mutex_unlock(&mural_lock);
-}
-
-module_t* mural_pop_front(void) {
-    pthread_mutex_lock(&mural_lock);
-    if (!mural_head) { pthread_mutex_unlock(&mural_lock); return NULL; }
-    module_t *m = mural_head;
-    mural_head = mural_head->next;
-    if (!mural_head) mural_tail = NULL;
-    m->next = NULL;
-    mural_size--;
-    pthread_mutex_unlock(&mural_lock);
-    return m;
+    // chegada atrasada de uma bomba que já terminou: não entra
+    if (!mural_bomb_open(m->bomb)) { module_free(m); return; }
+    atomic_fetch_add(&bomb_of(m)->arrived, 1);
+    mural_shard_t *sh = shard_of_id(m->id);
+    m->enqueued_ns = sim_now_ns();
+    LOCK(&sh->lock);
+    link_tail(sh, m);
+    log_record(LOG_EV_MURAL_ADDED, m->id, -1, -1, 0);
+    rec_emit(REC_PUSH, m->id, -1, -1, 0);
+    UNLOCK(&sh->lock);
+    coord_notify();
 }
 
-module_t* mural_pop(void) { return mural_pop_front(); }
+int mural_expire_due(long long now_ms);
 
-module_t* mural_pop_by_id(int id) {
-    pthread_mutex_lock(&mural_lock);
-    module_t *cur = mural_head;
-    module_t *prev = NULL;
-    while (cur) {
-        if (cur->id == id) {
-            if (prev) prev->next = cur->next;
-            else mural_head = cur->next;
-            if (cur == mural_tail) mural_tail = prev;
-            cur->next = NULL;
-            mural_size--;
-            pthread_mutex_unlock(&mural_lock);
-            return cur;
+// Seleção entre shards: cada shard propõe seu melhor candidato sob o
+// próprio lock; o vencedor é retirado depois, se ainda estiver lá
+// (mesmo seq no mesmo shard), senão a escolha recomeça.
+typedef struct {
+    module_t *m;
+    unsigned long long seq;
+    int live;               // ainda no heap de prazos (não vencido)
+    long long deadline;
+    int time_required;
+    int id;
+} pick_t;
+
+static int pick_before(const pick_t *a, const pick_t *b, int edf) {
+    if (edf) {
+        if (a->live != b->live) return a->live;
+        if (a->live) {
+            if (a->deadline != b->deadline) return a->deadline < b->deadline;
+            if (a->time_required != b->time_required) return a->time_required < b->time_required;
+            return a->id < b->id;
         }
-        prev = cur;
-        cur = cur->next;
     }
-    pthread_mutex_unlock(&mural_lock);
-    return NULL;
+    return a->seq < b->seq;
 }
 
-void mural_requeue(module_t *m) {
-    if (!m) return;
-    pthread_mutex_lock(&mural_lock);
-    m->next = NULL;
-    if (!mural_head) { mural_head = mural_tail = m; } 
-    else { mural_tail->next = m; mural_tail = m; }
-    mural_size++;
-    log_event("[MURAL] M%d re-enfileirado", m->id);
-    pthread_mutex_unlock(&mural_lock);
-}
-
-module_t* mural_peek_list(void) { return mural_head; }
-int mural_count(void) { return mural_size; }
-
-module_t* mural_find_by_tedax_type(int tedax_id, char type_char) {
-    (void)tedax_id; 
-    pthread_mutex_lock(&mural_lock);
-    module_t *cur = mural_head;
-    while (cur) {
-        char cur_type_char = (cur->type == MOD_FIOS) ? 'F' : (cur->type == MOD_BOTAO) ? 'B' : (cur->type == MOD_SENHAS) ? 'S' : '?';
-        if (cur_type_char == type_char) {
-            pthread_mutex_unlock(&mural_lock);
-            return cur;
+static module_t* pop_selected(int edf) {
+    for (;;) {
+        pick_t best = {0};
+        int best_shard = -1;
+        // EDF: o topo de cada heap é o prazo vivo mais próximo. Vencidos já
+        // saíram dos heaps (explodiriam na mão do tedax); só são servidos
+        // quando não há outro.
+        if (edf) mural_expire_due(sim_now_ms());
+        for (int i = 0; i < MURAL_SHARDS; ++i) {
+            mural_shard_t *sh = &shards[i];
+            LOCK(&sh->lock);
+            module_t *m = (edf && sh->dl_len > 0) ? sh->dl_heap[0] : sh->head;
+            if (m) {
+                pick_t c = { m, m->seq, m->heap_idx >= 0, deadline_of(m), m->time_required, m->id };
+                if (best_shard < 0 || pick_before(&c, &best, edf)) { best = c; best_shard = i; }
+            }
+            UNLOCK(&sh->lock);
+        }
+        if (best_shard < 0) return NULL;
+
+        mural_shard_t *sh = &shards[best_shard];
+        LOCK(&sh->lock);
+        int still = best.m->shard == best_shard && best.m->seq == best.seq;
+        if (still) unlink_node(sh, best.m);
+        UNLOCK(&sh->lock);
+        if (still) {
+            note_dispatched(best.m);
+            return best.m;
         }
-        cur = cur->next;
     }
-    pthread_mutex_unlock(&mural_lock);
-    return NULL;
 }
 
-module_t* mural_get_by_index(int index) {
-    pthread_mutex_lock(&mural_lock);
-    module_t *cur = mural_head;
-    int i = 0;
-    while (cur && i < index) { cur = cur->next; i++; }
-    pthread_mutex_unlock(&mural_lock);
-    return cur; 
+module_t* mural_pop_front(void) { return pop_selected(0); }
+module_t* mural_pop_earliest(void) { return pop_selected(1); }
+
+module_t* mural_pop(void) {
+    return atomic_load(&dispatch_policy) == MURAL_POLICY_EDF ? mural_pop_earliest() : mural_pop_front();
+}
+
+// Ordem do lote: primeiro quem ainda dá tempo de resolver (prazo restante
+// >= tentativa mínima, metade de time_required); depois a política.
+// Condenados só pegam recursos que sobrariam ociosos.
+typedef struct {
+    module_t *m;
+    int doomed;
+    long long deadline;
+    int time_required;
+    unsigned long long seq;
+    int shard;
+} batch_cand_t;
+
+static int batch_before(const batch_cand_t *a, const batch_cand_t *b, mural_policy_t policy) {
+    if (a->doomed != b->doomed) return !a->doomed;
+    if (policy == MURAL_POLICY_EDF) {
+        if (a->deadline != b->deadline) return a->deadline < b->deadline;
+        if (a->time_required != b->time_required) return a->time_required < b->time_required;
+    }
+    return a->seq < b->seq; // ordem de chegada
+}
+
+// Top-k por bomba: cada shard é varrido sob o próprio lock e cada
+// candidato entra no ranking da sua bomba; os rankings são intercalados
+// pelo escalonador entre bombas e os escolhidos são retirados shard a
+// shard. Quem sumiu no meio do caminho (atribuição manual) fica de fora.
+//
+// Escalonador (stride scheduling): cada par entregue a uma bomba avança
+// o passe dela em BOMB_STRIDE / peso, e o próximo par vai para a bomba
+// de menor passe que tenha candidato. Uma bomba que passou um tempo sem
+// módulos entra no passe corrente, sem acumular crédito. Viáveis de
+// todas as bombas vêm antes de qualquer condenado.
+#define BOMB_STRIDE (1ull << 20)
+
+int mural_take_batch(module_t **out, int max) {
+    if (max <= 0 || atomic_load(&active_count) == 0) return 0;
+    if (max > MURAL_BATCH_MAX) max = MURAL_BATCH_MAX;
+    mural_policy_t policy = atomic_load(&dispatch_policy);
+    long long now = sim_now_ms();
+
+    // top-k por inserção: k é o número de pares livres (pequeno)
+    batch_cand_t best[MURAL_MAX_BOMBS][MURAL_BATCH_MAX];
+    int n[MURAL_MAX_BOMBS] = {0};
+    for (int s = 0; s < MURAL_SHARDS; ++s) {
+        mural_shard_t *sh = &shards[s];
+        LOCK(&sh->lock);
+        for (module_t *m = sh->head; m; m = m->next) {
+            int b = (int)(bomb_of(m) - bombs);
+            batch_cand_t *rank = best[b];
+            batch_cand_t c = { m, 0, deadline_of(m), m->time_required, m->seq, s };
+            c.doomed = m->expired || (c.deadline - now) < (m->time_required + 1) / 2 * 1000LL;
+            if (n[b] == max && !batch_before(&c, &rank[n[b] - 1], policy)) continue;
+            int i = n[b] < max ? n[b]++ : n[b] - 1;
+            while (i > 0 && batch_before(&c, &rank[i - 1], policy)) { rank[i] = rank[i - 1]; i--; }
+            rank[i] = c;
+        }
+        UNLOCK(&sh->lock);
+    }
+
+    const batch_cand_t *order[MURAL_BATCH_MAX];
+    int k = 0, pos[MURAL_MAX_BOMBS] = {0};
+    LOCK(&sched_lock);
+    for (int b = 0; b < n_bombs; ++b)
+        if (n[b] > 0 && bombs[b].pass < sched_vtime) bombs[b].pass = sched_vtime;
+    for (int doomed = 0; doomed <= 1; ++doomed) {
+        while (k < max) {
+            int pick = -1;
+            for (int b = 0; b < n_bombs; ++b) {
+                if (pos[b] == n[b] || best[b][pos[b]].doomed != doomed) continue;
+                if (pick < 0 || bombs[b].pass < bombs[pick].pass) pick = b;
+            }
+            if (pick < 0) break;
+            order[k++] = &best[pick][pos[pick]++];
+            sched_vtime = bombs[pick].pass;
+            bombs[pick].pass += BOMB_STRIDE / (unsigned long long)bombs[pick].weight;
+        }
+    }
+    UNLOCK(&sched_lock);
+
+    int taken = 0;
+    for (int i = 0; i < k; ++i) {
+        const batch_cand_t *c = order[i];
+        mural_shard_t *sh = &shards[c->shard];
+        LOCK(&sh->lock);
+        if (c->m->shard == c->shard && c->m->seq == c->seq) {
+            unlink_node(sh, c->m);
+            out[taken++] = c->m;
+        }
+        UNLOCK(&sh->lock);
+    }
+    for (int i = 0; i < taken; ++i) note_dispatched(out[i]);
+    return taken;
+}
+
+void mural_set_policy(mural_policy_t policy) { atomic_store(&dispatch_policy, policy); }
+mural_policy_t mural_get_policy(void) { return atomic_load(&dispatch_policy); }
+
+const char* mural_policy_name(mural_policy_t policy) {
+    return policy == MURAL_POLICY_EDF ? "edf" : "fifo";
+}
+
+int mural_policy_parse(const char *name, mural_policy_t *out) {
+    if (strcmp(name, "fifo") == 0) *out = MURAL_POLICY_FIFO;
+    else if (strcmp(name, "edf") == 0) *out = MURAL_POLICY_EDF;
+    else return -1;
+    return 0;
+}
+
+module_t* mural_pop_by_id(int id) {
+    mural_shard_t *sh = shard_of_id(id);
+    LOCK(&sh->lock);
+    module_t *m = id_index_find(sh, id);
+    if (m) unlink_node(sh, m);
+    UNLOCK(&sh->lock);
+    if (m) note_dispatched(m); // atribuição manual
+    return m;
+}
+
+void mural_requeue(module_t *m) {
+    if (!m) return;
+    if (!mural_bomb_open(m->bomb)) { module_free(m); return; }
+    mural_shard_t *sh = shard_of_id(m->id);
+    m->enqueued_ns = sim_now_ns();
+    LOCK(&sh->lock);
+    link_tail(sh, m);
+    log_record(LOG_EV_MURAL_REQUEUED, m->id, -1, -1, 0);
+    rec_emit(REC_REQUEUE, m->id, -1, -1, 0);
+    UNLOCK(&sh->lock);
+    metrics_inc(MET_C_REQUEUES);
 }
 
+int mural_count(void) { return atomic_load(&active_count); }
+
 // =====================================================
 //  Gestão de Resolvidos (NOVO)
 // =====================================================
 void mural_add_to_resolved(module_t *m) {
     if (!m) return;
-    pthread_mutex_lock(&mural_lock);
+    LOCK(&resolved_lock);
     // Insere no início da lista (Pilha) para ver os mais recentes primeiro
+    m->prev = NULL;
     m->next = resolved_head;
+    if (resolved_head) resolved_head->prev = m;
+    else resolved_tail = m;
     resolved_head = m;
-    pthread_mutex_unlock(&mural_lock);
+    resolved_count++;
+    atomic_fetch_add(&resolved_total, 1);
+    if (m->type >= 0 && m->type < NUM_MODULE_TYPES) atomic_fetch_add(&resolved_by_type[m->type], 1);
+
+    // Os mais antigos já estão no resumo: devolve-os ao pool
+    while (resolved_keep >= 0 && resolved_count > resolved_keep) {
+        module_t *old = resolved_tail;
+        resolved_tail = old->prev;
+        if (resolved_tail) resolved_tail->next = NULL;
+        else resolved_head = NULL;
+        resolved_count--;
+        module_free(old);
+    }
+    mural_changed();
+    UNLOCK(&resolved_lock);
+}
+
+void mural_set_resolved_keep(int keep) {
+    LOCK(&resolved_lock);
+    resolved_keep = keep;
+    UNLOCK(&resolved_lock);
 }
 
-module_t* mural_peek_resolved(void) {
-    return resolved_head;
+int mural_resolved_total(void) { return atomic_load(&resolved_total); }
+
+int mural_resolved_by_type(module_type_t type) {
+    return (type >= 0 && type < NUM_MODULE_TYPES) ? atomic_load(&resolved_by_type[type]) : 0;
 }
 
+size_t mural_pool_capacity(void) { return module_slab ? slab_capacity(module_slab) : 0; }
+size_t mural_pool_in_use(void) { return module_slab ? slab_in_use(module_slab) : 0; }
+
 // =====================================================
-//  Init / Destroy / Utils
+//  Bombas
 // =====================================================
-void mural_init(void) {
-    pthread_mutex_lock(&mural_lock);
-    mural_head = mural_tail = NULL;
-    resolved_head = NULL;
-    mural_size = 0;
-    global_score = 0;
-    global_money = MOEDAS_INICIAL;
-    game_deadline = 0; 
-    pthread_mutex_unlock(&mural_lock);
+// Requer threads estacionadas (início de rodada)
+static void bombs_reset(int n, const mural_bomb_cfg_t *cfg, int duration_seconds) {
+    long long now = sim_now_ms();
+    LOCK(&sched_lock);
+    for (int i = 0; i < n; ++i) {
+        bomb_t *b = &bombs[i];
+        int sec = cfg && cfg[i].duration_sec > 0 ? cfg[i].duration_sec : duration_seconds;
+        b->weight = cfg && cfg[i].weight > 0 ? cfg[i].weight : 1;
+        atomic_store(&b->state, BOMB_ARMED);
+        atomic_store(&b->score, 0);
+        atomic_store(&b->active, 0);
+        atomic_store(&b->arrived, 0);
+        atomic_store(&b->served, 0);
+        atomic_store(&b->wait_ns, 0);
+        atomic_store(&b->deadline, sec > 0 ? now + (long long)sec * 1000 : 0);
+        b->pass = 0;
+    }
+    sched_vtime = 0;
+    n_bombs = n;
+    UNLOCK(&sched_lock);
+    atomic_store(&bombs_armed, n);
+    atomic_store(&bombs_defused, 0);
 }
 
-void mural_destroy(void) {
-    pthread_mutex_lock(&mural_lock);
-    // Limpa ativos
-    module_t *cur = mural_head;
-    while (cur) {
-        module_t *n = cur->next;
-        free(cur);
-        cur = n;
+// o timer global é o da próxima bomba armada a vencer; sem nenhuma
+// armada ele fica como estava (o placar final continua na tela)
+static void refresh_deadline(void) {
+    long long next = 0;
+    for (int i = 0; i < n_bombs; ++i) {
+        long long d = atomic_load(&bombs[i].deadline);
+        if (atomic_load(&bombs[i].state) == BOMB_ARMED && d && (!next || d < next)) next = d;
     }
-    // Limpa resolvidos
-    cur = resolved_head;
-    while (cur) {
-        module_t *n = cur->next;
-        free(cur);
-        cur = n;
+    if (next) atomic_store(&game_deadline, next);
+}
+
+// Tira do mural os módulos de uma bomba que terminou (um shard por vez)
+static int purge_bomb(int bomb) {
+    int n = 0;
+    for (int i = 0; i < MURAL_SHARDS; ++i) {
+        mural_shard_t *sh = &shards[i];
+        LOCK(&sh->lock);
+        for (module_t *m = sh->head, *next; m; m = next) {
+            next = m->next;
+            if (m->bomb != bomb) continue;
+            unlink_node(sh, m);
+            module_free(m);
+            n++;
+        }
+        UNLOCK(&sh->lock);
+    }
+    return n;
+}
+
+static void bomb_end(int bomb, bomb_state_t how) {
+    int armed = BOMB_ARMED;
+    if (!atomic_compare_exchange_strong(&bombs[bomb].state, &armed, (int)how)) return;
+    if (how == BOMB_DEFUSED) atomic_fetch_add(&bombs_defused, 1);
+    int left = atomic_fetch_sub(&bombs_armed, 1) - 1;
+    mural_changed();
+    if (left > 0) {
+        // as outras seguem: os módulos desta só ocupariam tedax
+        refresh_deadline();
+        int dropped = purge_bomb(bomb);
+        if (how == BOMB_DEFUSED)
+            log_event("[BOMBA %d] Desarmada com sucesso (%d modulos descartados, %d armadas)", bomb + 1, dropped, left);
+        else
+            log_event("[BOMBA %d] EXPLODIU: tempo esgotado (%d modulos descartados, %d armadas)", bomb + 1, dropped, left);
+        return;
+    }
+    // a última bomba decide a rodada e acorda o laço principal
+    halt_raise(atomic_load(&bombs_defused) == n_bombs ? HALT_WIN : HALT_TIME);
+}
+
+void mural_setup_bombs(int n, const mural_bomb_cfg_t *cfg, int duration_seconds) {
+    if (n < 1 || !cfg) { n = 1; cfg = NULL; }
+    if (n > MURAL_MAX_BOMBS) n = MURAL_MAX_BOMBS;
+    bombs_reset(n, cfg, duration_seconds);
+    refresh_deadline();
+    mural_changed();
+}
+
+int mural_parse_bomb(const char *spec, mural_bomb_cfg_t *out) {
+    int w, sec = 0, gen = 0;
+    int got = sscanf(spec, "%d:%d:%d", &w, &sec, &gen);
+    if (got < 1 || w < 1 || sec < 0 || gen < 0) return -1;
+    out->weight = w;
+    out->duration_sec = sec;
+    out->gen_interval_ms = gen;
+    return 0;
+}
+
+int mural_bomb_count(void) { return n_bombs; }
+
+int mural_bomb_open(int bomb) {
+    if (n_bombs == 1) return 1; // modo clássico: a rodada acaba junto com a bomba
+    if (bomb < 0 || bomb >= n_bombs) return 0;
+    return atomic_load(&bombs[bomb].state) == BOMB_ARMED;
+}
+
+int mural_bombs_armed(void) { return atomic_load(&bombs_armed); }
+int mural_bombs_defused(void) { return atomic_load(&bombs_defused); }
+
+int mural_check_bomb_timers(long long now_ms) {
+    int n = 0;
+    for (int i = 0; i < n_bombs; ++i) {
+        long long d = atomic_load(&bombs[i].deadline);
+        if (d && d <= now_ms && atomic_load(&bombs[i].state) == BOMB_ARMED) {
+            bomb_end(i, BOMB_EXPLODED);
+            n++;
+        }
     }
-    mural_head = mural_tail = NULL;
-    resolved_head = NULL;
-    mural_size = 0;
-    pthread_mutex_unlock(&mural_lock);
+    return n;
 }
 
-void mural_lock_access(void) { pthread_mutex_lock(&mural_lock); }
-void mural_unlock_access(void) { pthread_mutex_unlock(&mural_lock); }
+void mural_bomb_stats(int bomb, mural_bomb_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (bomb < 0 || bomb >= n_bombs) return;
+    const bomb_t *b = &bombs[bomb];
+    out->state = atomic_load(&b->state);
+    out->weight = b->weight;
+    out->score = atomic_load(&b->score);
+    out->active = atomic_load(&b->active);
+    out->arrived = atomic_load(&b->arrived);
+    out->served = atomic_load(&b->served);
+    out->wait_ms = atomic_load(&b->wait_ns) / 1000000;
+    out->deadline_ms = atomic_load(&b->deadline);
+}
 
 // =====================================================
-//  Score, Dinheiro e TIMER
+//  Init / Destroy / Utils
 // =====================================================
-void mural_add_score(void) {
-    pthread_mutex_lock(&mural_lock);
-    global_score++;
-    pthread_mutex_unlock(&mural_lock);
+void mural_init(void) {
+    if (!shards_ready) {
+        for (int i = 0; i < MURAL_SHARDS; ++i) pthread_mutex_init(&shards[i].lock, NULL);
+        shards_ready = 1;
+    }
+    for (int i = 0; i < MURAL_SHARDS; ++i) {
+        LOCK(&shards[i].lock);
+        shard_reset(&shards[i]);
+        UNLOCK(&shards[i].lock);
+    }
+    atomic_store(&next_seq, 0);
+    atomic_store(&active_count, 0);
+    wait_clock_reset();
+    atomic_store(&expired_total, 0);
+
+    LOCK(&resolved_lock);
+    resolved_head = resolved_tail = NULL;
+    resolved_count = 0;
+    atomic_store(&resolved_total, 0);
+    for (int i = 0; i < NUM_MODULE_TYPES; ++i) atomic_store(&resolved_by_type[i], 0);
+    if (!module_slab) module_slab = slab_create(sizeof(module_t));
+    UNLOCK(&resolved_lock);
+
+    atomic_store(&global_score, 0);
+    atomic_store(&global_money, MOEDAS_INICIAL);
+    atomic_store(&game_deadline, 0);
+    bombs_reset(1, NULL, 0);   // sem timer até mural_setup_bombs
+    mural_changed();
 }
 
-int mural_get_score(void) {
-    int s;
-    pthread_mutex_lock(&mural_lock);
-    s = global_score;
-    pthread_mutex_unlock(&mural_lock);
-    return s;
+void mural_destroy(void) {
+    for (int i = 0; i < MURAL_SHARDS; ++i) LOCK(&shards[i].lock);
+    LOCK(&resolved_lock);
+    // Ativos, resolvidos e módulos ainda nas mãos dos tedax vivem todos no
+    // pool da partida: esvaziá-lo de uma vez limpa tudo. Os blocos ficam
+    // para a próxima rodada, que não volta a alocar.
+    slab_reset(module_slab);
+    for (int i = 0; i < MURAL_SHARDS; ++i) shard_reset(&shards[i]);
+    atomic_store(&active_count, 0);
+    wait_clock_reset();
+    for (int i = 0; i < n_bombs; ++i) atomic_store(&bombs[i].active, 0);
+    resolved_head = resolved_tail = NULL;
+    resolved_count = 0;
+    UNLOCK(&resolved_lock);
+    for (int i = MURAL_SHARDS - 1; i >= 0; --i) UNLOCK(&shards[i].lock);
+    mural_changed(); // leitores passam a ver o mural vazio
 }
 
-void mural_add_money(int amount) {
-    pthread_mutex_lock(&mural_lock);
-    global_money += amount;
-    pthread_mutex_unlock(&mural_lock);
+// =====================================================
+//  Score, Dinheiro e TIMER (atômicos, fora dos locks do mural)
+// =====================================================
+void mural_add_score(int bomb) {
+    atomic_fetch_add(&global_score, 1);
+    bomb_t *b = &bombs[bomb > 0 && bomb < n_bombs ? bomb : 0];
+    int score = atomic_fetch_add(&b->score, 1) + 1;
+    mural_changed();
+    // só quem cruza a meta desarma a bomba
+    if (score == WIN_SCORE_TARGET) bomb_end((int)(b - bombs), BOMB_DEFUSED);
 }
 
-int mural_get_money(void) {
-    int m;
-    pthread_mutex_lock(&mural_lock);
-    m = global_money;
-    pthread_mutex_unlock(&mural_lock);
-    return m;
+int mural_get_score(void) { return atomic_load(&global_score); }
+
+void mural_add_money(int amount) {
+    atomic_fetch_add(&global_money, amount);
+    mural_changed();
 }
 
-void mural_setup_timer(int duration_seconds) {
-    pthread_mutex_lock(&mural_lock);
-    game_deadline = time(NULL) + duration_seconds;
-    pthread_mutex_unlock(&mural_lock);
+int mural_get_money(void) { return atomic_load(&global_money); }
+
+long long mural_get_deadline_ms(void) { return atomic_load(&game_deadline); }
+
+long long mural_get_remaining_ms(void) {
+    long long dl = atomic_load(&game_deadline);
+    long long ret = dl == 0 ? 0 : dl - sim_now_ms();
+    return ret < 0 ? 0 : ret;
 }
 
 int mural_get_remaining_seconds(void) {
-    pthread_mutex_lock(&mural_lock);
-    if (game_deadline == 0) {
-        pthread_mutex_unlock(&mural_lock);
-        return 0;
-    }
-    time_t now = time(NULL);
-    double diff = difftime(game_deadline, now);
-    int ret = (int)diff;
-    if (ret < 0) ret = 0;
-    pthread_mutex_unlock(&mural_lock);
-    return ret;
-}
\ No newline at end of file
+    return (int)((mural_get_remaining_ms() + 999) / 1000);
+}
+
+// =====================================================
+//  Expiração (substitui a varredura de 1s do watcher)
+// =====================================================
+// Requer sh->lock. Cada módulo vencido vai para o fim da fila uma única
+// vez (como fazia o watcher) e sai do heap até receber um novo prazo.
+static int expire_one_locked(mural_shard_t *sh) {
+    module_t *m = sh->dl_heap[0];
+    // atraso entre o prazo e a detecção (zero no relógio virtual)
+    metrics_record_us(MET_H_EXPIRY_DETECT, sim_now_ns() / 1000 - deadline_of(m) * 1000);
+    unlink_node(sh, m);
+    m->expired = 1;
+    link_tail(sh, m);
+    log_record(LOG_EV_WATCHER_TIMEOUT, m->id, -1, -1, 0);
+    rec_emit(REC_TIMEOUT, m->id, -1, -1, 0);
+    atomic_fetch_add(&expired_total, 1);
+    metrics_inc(MET_C_TIMEOUTS);
+    return 1;
+}
+
+int mural_expired_total(void) { return atomic_load(&expired_total); }
+
+// menor topo entre os shards (0 se nenhum tem prazo pendente)
+static int earliest_shard(long long *out) {
+    int best = -1;
+    long long bd = 0;
+    for (int i = 0; i < MURAL_SHARDS; ++i) {
+        long long d = atomic_load(&shards[i].top_deadline);
+        if (d && (best < 0 || d < bd)) { best = i; bd = d; }
+    }
+    *out = bd;
+    return best;
+}
+
+// Vencidos saem na ordem global dos prazos (um por vez, no shard do
+// menor topo), então a fila final não depende da divisão em shards.
+int mural_expire_due(long long now_ms) {
+    int n = 0;
+    for (;;) {
+        long long d;
+        int s = earliest_shard(&d);
+        if (s < 0 || d > now_ms) return n;
+        mural_shard_t *sh = &shards[s];
+        LOCK(&sh->lock);
+        if (sh->dl_len > 0 && deadline_of(sh->dl_heap[0]) <= now_ms) n += expire_one_locked(sh);
+        UNLOCK(&sh->lock);
+    }
+}
+
+long long mural_next_deadline(void) {
+    long long d;
+    earliest_shard(&d);
+    return d;
+}
+
+// A thread de expiração dorme até o menor topo entre os shards. Quem
+// publica um topo mais cedo que o prazo armado (expiry_armed) a acorda:
+// o topo é publicado antes de ler expiry_armed, e a thread arma antes de
+// reler os topos, então um dos dois sempre vê o outro.
+static pthread_mutex_t expiry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t expiry_cond = PTHREAD_COND_INITIALIZER;
+static atomic_llong expiry_armed = LLONG_MAX;
+static pthread_t expiry_thread;
+static park_t expiry_park = PARK_INITIALIZER;   // estaciona entre rodadas
+static int expiry_running = 0;
+
+// Requer o lock do shard que acabou de publicar o topo
+static void expiry_kick(long long deadline) {
+    if (deadline >= atomic_load(&expiry_armed)) return;
+    LOCK(&expiry_mutex);
+    pthread_cond_signal(&expiry_cond);
+    UNLOCK(&expiry_mutex);
+}
+
+static void expiry_round(void) {
+    LOCK(&expiry_mutex);
+    while (expiry_running) {
+        long long next;
+        earliest_shard(&next);
+        long long now = sim_now_ms();
+        if (next && next <= now) {
+            UNLOCK(&expiry_mutex);
+            mural_expire_due(now);
+            LOCK(&expiry_mutex);
+            continue;
+        }
+        atomic_store(&expiry_armed, next ? next : LLONG_MAX);
+        long long again;
+        earliest_shard(&again);
+        if (again != next) continue; // um topo mudou enquanto armávamos
+        if (!next) {
+            // mural sem prazos: dorme até um push
+            COND_WAIT(&expiry_cond, &expiry_mutex);
+        } else {
+            struct timespec ts;
+            sim_abs_timespec(next, &ts);
+            COND_TIMEDWAIT(&expiry_cond, &expiry_mutex, &ts);
+        }
+    }
+    atomic_store(&expiry_armed, LLONG_MAX);
+    UNLOCK(&expiry_mutex);
+}
+
+static void* expiry_fn(void *arg) {
+    (void)arg;
+    do {
+        expiry_round();
+    } while (park_enter(&expiry_park));
+    return NULL;
+}
+
+void mural_expiry_start(void) {
+    static int cond_ready = 0;
+    if (!cond_ready) { sim_cond_init(&expiry_cond); cond_ready = 1; } // espera no relógio monotônico
+    LOCK(&expiry_mutex);
+    expiry_running = 1;
+    UNLOCK(&expiry_mutex);
+    if (park_threads(&expiry_park) > 0) park_open(&expiry_park);
+    else park_spawn(&expiry_park, &expiry_thread, expiry_fn, NULL);
+}
+
+void mural_expiry_stop(void) {
+    LOCK(&expiry_mutex);
+    expiry_running = 0;
+    pthread_cond_signal(&expiry_cond);
+    UNLOCK(&expiry_mutex);
+    park_close(&expiry_park);
+}
+
+void mural_expiry_exit(void) {
+    if (park_threads(&expiry_park) == 0) return;
+    park_exit(&expiry_park, &expiry_thread);
+}
@@ -1,54 +1,165 @@
 #ifndef MURAL_H
 #define MURAL_H
 
+#include <stddef.h>
 #include <time.h>
 
+#include "config.h"
+#include "rng.h"
+
 typedef enum { MOD_FIOS=0, MOD_BOTAO=1, MOD_SENHAS=2 } module_type_t;
 
 typedef struct module {
     int id;
     module_type_t type;
-    int time_required;
-    time_t created_at;
-    int timeout_secs;
+    int time_required;     // segundos (valor de projeto do tipo)
+    long long created_ms;  // relógio do jogo (sim_now_ms)
+    int timeout_ms;
 
     char solution[64];     
     char instruction[64];  
 
-    struct module *next;
+    struct module *next;       // ordem FIFO (também usada pela lista de resolvidos)
+    struct module *prev;
+    struct module *type_next;  // lista intrusiva por module_type_t
+    struct module *type_prev;
+    struct module *hash_next;  // cadeia do índice id -> módulo
+    unsigned long long seq;    // ordem global de chegada (FIFO entre shards)
+    int shard;                 // shard em que está ligado (-1 = fora do mural)
+    int heap_idx;              // posição no heap de prazos do shard (-1 = fora)
+    int expired;               // timeout já reportado (não volta ao heap)
+    int bomb;                  // bomba dona do módulo (0 no modo clássico)
+    long long enqueued_ns;     // entrada no mural (push/requeue), para a métrica de espera
 } module_t;
 
+// Visão compacta e imutável de um módulo, para leitores sem lock
+typedef struct {
+    int id;
+    module_type_t type;
+    int time_required;
+    long long deadline_ms;  // created_ms + timeout_ms
+    int bomb;
+} module_view_t;
+
+// Multi-bomba: cada bomba tem timer, score e chegadas próprios (os módulos
+// levam o número da bomba) e todas disputam o mesmo pool de tedax e
+// bancadas. O despacho em lote reparte os pares livres entre as bombas
+// por stride scheduling, na proporção dos pesos. Uma bomba termina
+// DESARMADA (score da bomba = WIN_SCORE_TARGET) ou EXPLODIDA (timer
+// vencido); a rodada acaba quando nenhuma segue armada.
+typedef enum { BOMB_ARMED = 0, BOMB_DEFUSED, BOMB_EXPLODED } bomb_state_t;
+
+typedef struct {
+    int weight;             // parcela do despacho (>= 1)
+    int duration_sec;       // timer próprio (0 = o da partida)
+    int gen_interval_ms;    // intervalo médio de chegadas (0 = o da carga)
+} mural_bomb_cfg_t;
+
+typedef struct {
+    int state;              // bomb_state_t
+    int weight;
+    int score;
+    int active;             // módulos no mural agora
+    int arrived;            // chegadas (sem contar devoluções)
+    int served;             // despachados para um tedax
+    long long wait_ms;      // espera somada dos despachados no mural
+    long long deadline_ms;
+} mural_bomb_stats_t;
+
+#define MURAL_SNAPSHOT_MAX 128   // views por lista (a UI mostra bem menos)
+
+typedef struct {
+    unsigned long version;
+    int active_count;       // total de ativos (pode passar de active_n)
+    int active_n;
+    module_view_t active[MURAL_SNAPSHOT_MAX];
+    int resolved_total;
+    int resolved_n;         // mais recentes primeiro
+    module_view_t resolved[MURAL_SNAPSHOT_MAX];
+    int score;
+    int money;
+    long long deadline_ms;  // 0 = timer não configurado
+    int bombs;              // 1 = modo clássico
+    mural_bomb_stats_t bomb[MURAL_MAX_BOMBS];
+} mural_snapshot_t;
+
+// Política de despacho do auto-assign (mural_pop)
+typedef enum { MURAL_POLICY_FIFO = 0, MURAL_POLICY_EDF } mural_policy_t;
 
 void mural_init(void);
 void mural_destroy(void);
 
-module_t* create_module(int id);
+// aloca do pool da partida (mural_init); type < 0: sorteado. O conteúdo
+// sai do fluxo rng do produtor (que é quem o usa, sem lock)
+module_t* create_module_of_type(int id, int type, rng_t *rng, int producer);
+void module_free(module_t *m);          // devolve ao pool
 void mural_push(module_t *m);
 module_t* mural_pop_front(void);
 module_t* mural_pop_by_id(int id);
 void mural_requeue(module_t *m);
-module_t* mural_peek_list(void);
 int mural_count(void); 
-module_t* mural_pop(void);
-module_t* mural_find_by_tedax_type(int tedax_id, char type);
-void mural_lock_access(void);
-void mural_unlock_access(void);
+long long mural_waiting_ms(void);   // tempo da rodada com módulo no mural (ms)
+module_t* mural_pop(void);              // segue a política atual
+module_t* mural_pop_earliest(void);     // prazo mais próximo (empate: menor time_required)
+void mural_set_policy(mural_policy_t policy);
+mural_policy_t mural_get_policy(void);
+const char* mural_policy_name(mural_policy_t policy);
+int mural_policy_parse(const char *name, mural_policy_t *out); // 0 ok, -1 nome inválido
+
+// Retira até max módulos na ordem de despacho em lote (viáveis primeiro,
+// depois a política), escolhidos entre todos os shards e repartidos
+// entre as bombas pelos pesos. Pode retornar menos se algum candidato
+// for retirado por outra thread no meio.
+#define MURAL_BATCH_MAX 64
+int mural_take_batch(module_t **out, int max);
 
 // --- NOVO: Gestão de Resolvidos ---
 void mural_add_to_resolved(module_t *m);
-module_t* mural_peek_resolved(void);
+// Só os "keep" mais recentes ficam na lista; os demais entram no resumo
+// e voltam ao pool (-1 = mantém todos)
+void mural_set_resolved_keep(int keep);
+int mural_resolved_total(void);
+int mural_resolved_by_type(module_type_t type);
+
+// Estatísticas do pool de módulos
+size_t mural_pool_capacity(void);
+size_t mural_pool_in_use(void);
 
 // Score e Dinheiro
-void mural_add_score(void);
+void mural_add_score(int bomb);         // conta para a bomba e para o total
 int mural_get_score(void);
 void mural_add_money(int amount);
 int mural_get_money(void);
 
 // Interface
-module_t* mural_get_by_index(int index);
+unsigned long mural_version(void);      // muda a cada alteração visível do mural
+
+// Snapshot publicado a cada mudança; ler não toma mural_lock.
+// Todo acquire precisa de um release (o buffer fica preso até lá).
+const mural_snapshot_t* mural_snapshot_acquire(void);
+void mural_snapshot_release(const mural_snapshot_t *s);
+
+// Bombas. n = 0 ou cfg = NULL: uma bomba de peso 1 (modo clássico)
+void mural_setup_bombs(int n, const mural_bomb_cfg_t *cfg, int duration_seconds);
+int mural_parse_bomb(const char *spec, mural_bomb_cfg_t *out); // "PESO[:SEG[:INTERVALO_MS]]"
+int mural_bomb_count(void);
+int mural_bomb_open(int bomb);          // ainda recebe módulos (sempre, no modo clássico)
+int mural_bombs_armed(void);
+int mural_bombs_defused(void);
+int mural_check_bomb_timers(long long now_ms); // explode as vencidas; retorna quantas
+void mural_bomb_stats(int bomb, mural_bomb_stats_t *out);
+
+// Timer Global: o da próxima bomba armada a vencer
+int mural_get_remaining_seconds(void);  // arredondado para cima
+long long mural_get_remaining_ms(void);
+long long mural_get_deadline_ms(void);   // relógio do jogo (0 = sem timer)
 
-// Timer Global
-void mural_setup_timer(int duration_seconds);
-int mural_get_remaining_seconds(void);
+// Expiração de módulos (heap ordenado pelo prazo created_ms + timeout_ms)
+void mural_expiry_start(void);      // thread que dorme até o próximo prazo
+void mural_expiry_stop(void);       // a thread estaciona até o próximo start
+void mural_expiry_exit(void);       // fim do programa: encerra a thread
+int mural_expire_due(long long now_ms);  // processa prazos vencidos; retorna quantos
+long long mural_next_deadline(void);    // ms; 0 se não há prazo pendente
+int mural_expired_total(void);      // timeouts desde mural_init
 
 #endif // MURAL_H
\ No newline at end of file
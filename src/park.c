@@ -0,0 +1,62 @@
+#include "park.h"
+#include "lockprof.h"
+
+int park_spawn(park_t *p, pthread_t *thr, void *(*fn)(void *), void *arg) {
+    LOCK(&p->mutex);
+    p->threads++;
+    UNLOCK(&p->mutex);
+    if (pthread_create(thr, NULL, fn, arg) == 0) return 0;
+    LOCK(&p->mutex);
+    p->threads--;
+    UNLOCK(&p->mutex);
+    return -1;
+}
+
+int park_threads(park_t *p) {
+    LOCK(&p->mutex);
+    int n = p->threads;
+    UNLOCK(&p->mutex);
+    return n;
+}
+
+int park_enter(park_t *p) {
+    LOCK(&p->mutex);
+    // quem estaciona no meio da rodada (ex.: trace esgotado) espera a próxima
+    unsigned round = p->round;
+    p->parked++;
+    pthread_cond_broadcast(&p->cond);
+    while (p->round == round && !p->quit) COND_WAIT(&p->cond, &p->mutex);
+    int go = !p->quit;
+    UNLOCK(&p->mutex);
+    return go;
+}
+
+void park_open(park_t *p) {
+    LOCK(&p->mutex);
+    // as liberadas deixam de contar já aqui: um park_close logo em seguida
+    // espera que elas passem pelo laço da rodada e estacionem de novo
+    p->round++;
+    p->parked = 0;
+    pthread_cond_broadcast(&p->cond);
+    UNLOCK(&p->mutex);
+}
+
+void park_close(park_t *p) {
+    LOCK(&p->mutex);
+    while (p->parked < p->threads) COND_WAIT(&p->cond, &p->mutex);
+    UNLOCK(&p->mutex);
+}
+
+// Depois de park_close. thr: as threads na ordem de criação
+void park_exit(park_t *p, pthread_t *thr) {
+    LOCK(&p->mutex);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->cond);
+    int n = p->threads;
+    UNLOCK(&p->mutex);
+    for (int i = 0; i < n; ++i) pthread_join(thr[i], NULL);
+    LOCK(&p->mutex);
+    p->threads = p->parked = 0;
+    p->quit = 0;
+    UNLOCK(&p->mutex);
+}
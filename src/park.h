@@ -0,0 +1,38 @@
+#ifndef PARK_H
+#define PARK_H
+
+#include <pthread.h>
+
+// Threads de vida longa: criadas na primeira rodada, estacionam no fim de
+// cada uma e são liberadas pela seguinte, sem pthread_create/join entre
+// rodadas. O módulo dono mantém o próprio sinal de parada e o próprio
+// condvar; o portão só organiza a passagem de uma rodada para a outra.
+//
+// Cada thread roda   do { laço da rodada } while (park_enter(&portao));
+// park_enter volta quando a próxima rodada abre (1) ou no encerramento (0).
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    unsigned round;         // incrementa a cada park_open
+    int threads;            // criadas com park_spawn
+    int parked;
+    int quit;
+} park_t;
+
+#define PARK_INITIALIZER { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0 }
+
+// Cria uma thread que já começa na rodada atual (0 ou -1)
+int park_spawn(park_t *p, pthread_t *thr, void *(*fn)(void *), void *arg);
+int park_threads(park_t *p);
+
+// Thread: estaciona até a próxima rodada; 0 = encerrar
+int park_enter(park_t *p);
+
+// Dono: libera as estacionadas / espera todas estacionarem (depois de
+// acordá-las pelo próprio condvar) / encerra e faz o join
+void park_open(park_t *p);
+void park_close(park_t *p);
+void park_exit(park_t *p, pthread_t *thr);
+
+#endif // PARK_H
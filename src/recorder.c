@@ -0,0 +1,407 @@
+#define _POSIX_C_SOURCE 200809L
+#include "recorder.h"
+#include "config.h"
+#include "loadgen.h"
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if (REC_CAPACITY & (REC_CAPACITY - 1)) != 0
+#error "REC_CAPACITY deve ser potencia de 2"
+#endif
+
+_Static_assert(sizeof(rec_entry_t) == 32, "registro do gravador deve ter 32 bytes");
+
+// =====================================================
+//  Formato do arquivo
+// =====================================================
+// [cabeçalho, REC_HEADER_BYTES][capacity registros]. head é o próximo
+// ticket; o registro do ticket t fica no slot t & (capacity - 1).
+#define REC_MAGIC "KSNEREC1"
+#define REC_VERSION 3
+#define REC_HEADER_BYTES 256
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t capacity;
+    _Atomic uint64_t head;
+    rec_config_t cfg;
+} rec_header_t;
+
+_Static_assert(sizeof(rec_header_t) <= REC_HEADER_BYTES, "cabecalho do gravador grande demais");
+
+enum { REC_OFF = 0, REC_RECORDING, REC_REPLAYING };
+static atomic_int rec_mode;
+
+static const char *kind_names[REC_KIND_COUNT] = {
+    "ROUND", "ROUND_END", "GEN", "PUSH", "REQUEUE", "TIMEOUT", "CMD", "CMD+",
+    "ASSIGN", "BENCH_ACQ", "BENCH_REL", "OUTCOME", "RNG",
+};
+
+// gravação
+static int rec_fd = -1;
+static void *rec_map = NULL;
+static size_t rec_map_len = 0;
+static rec_header_t *rec_hdr = NULL;
+static rec_entry_t *rec_ring = NULL;
+static atomic_int rounds_recorded;
+
+// replay: gravação inteira em memória + captura da rodada em curso
+static rec_entry_t *rp_log = NULL;
+static int rp_n = 0;
+static int *rp_round_at = NULL;       // índice do REC_ROUND de cada rodada
+static int rp_rounds = 0;
+static rec_config_t rp_cfg;
+
+static int rp_lo = 0, rp_hi = 0;      // rodada selecionada: [lo, hi)
+static long long rp_round_ts = 0;     // ts do REC_ROUND gravado
+static long long rp_start_ns = 0;     // relógio do replay no início da rodada
+static int rp_gen_cur[LOADGEN_MAX_PRODUCERS];
+static int rp_producers = 0;
+static int rp_cmd_cur = 0;
+static int rp_rng_cur[REC_RNG_SITES][LOADGEN_MAX_PRODUCERS];   // por ponto e dono (0 = fila única)
+static int rp_rng_short = 0;          // sorteios além dos gravados
+
+static rec_entry_t *cap = NULL;       // só o laço da simulação grava aqui
+static int cap_n = 0, cap_size = 0;
+
+// =====================================================
+//  Gravação
+// =====================================================
+int rec_recording(void) { return atomic_load_explicit(&rec_mode, memory_order_relaxed) == REC_RECORDING; }
+int rec_replaying(void) { return atomic_load_explicit(&rec_mode, memory_order_relaxed) == REC_REPLAYING; }
+
+int rec_open(const char *path, const rec_config_t *cfg) {
+    if (rec_map) return -1;
+    rec_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (rec_fd < 0) return -1;
+    rec_map_len = REC_HEADER_BYTES + (size_t)REC_CAPACITY * sizeof(rec_entry_t);
+    // arquivo esparso: só as páginas tocadas ocupam disco
+    if (ftruncate(rec_fd, (off_t)rec_map_len) != 0) { close(rec_fd); rec_fd = -1; return -1; }
+    rec_map = mmap(NULL, rec_map_len, PROT_READ | PROT_WRITE, MAP_SHARED, rec_fd, 0);
+    if (rec_map == MAP_FAILED) { rec_map = NULL; close(rec_fd); rec_fd = -1; return -1; }
+
+    rec_hdr = rec_map;
+    rec_ring = (rec_entry_t*)((char*)rec_map + REC_HEADER_BYTES);
+    memcpy(rec_hdr->magic, REC_MAGIC, sizeof(rec_hdr->magic));
+    rec_hdr->version = REC_VERSION;
+    rec_hdr->entry_size = sizeof(rec_entry_t);
+    rec_hdr->capacity = REC_CAPACITY;
+    atomic_store(&rec_hdr->head, 0);
+    rec_hdr->cfg = *cfg;
+    atomic_store(&rounds_recorded, 0);
+    atomic_store(&rec_mode, REC_RECORDING);
+    return 0;
+}
+
+void rec_close(void) {
+    if (!rec_map) return;
+    atomic_store(&rec_mode, REC_OFF);
+    msync(rec_map, rec_map_len, MS_SYNC);
+    munmap(rec_map, rec_map_len);
+    close(rec_fd);
+    rec_map = NULL;
+    rec_hdr = NULL;
+    rec_ring = NULL;
+    rec_fd = -1;
+}
+
+static rec_entry_t* claim(uint64_t *ticket) {
+    if (rec_recording()) {
+        *ticket = atomic_fetch_add_explicit(&rec_hdr->head, 1, memory_order_relaxed);
+        return &rec_ring[*ticket & (REC_CAPACITY - 1)];
+    }
+    if (cap_n == cap_size) {
+        int ncap = cap_size ? cap_size * 2 : 4096;
+        rec_entry_t *n = realloc(cap, (size_t)ncap * sizeof(rec_entry_t));
+        if (!n) return NULL;
+        cap = n; cap_size = ncap;
+    }
+    *ticket = (uint64_t)cap_n;
+    return &cap[cap_n++];
+}
+
+static void publish(rec_entry_t *e, uint64_t ticket) {
+    // commit por último: um leitor do arquivo descarta slots a meio da escrita
+    atomic_thread_fence(memory_order_release);
+    e->commit = (uint32_t)(ticket + 1);
+}
+
+static void emit_raw(rec_kind_t kind, int len, const void *payload) {
+    uint64_t t;
+    rec_entry_t *e = claim(&t);
+    if (!e) return;
+    e->ts_ns = sim_now_ns();
+    e->kind = (uint16_t)kind;
+    e->len = (uint16_t)len;
+    memcpy(e->u.text, payload, REC_TEXT_BYTES);
+    publish(e, t);
+}
+
+void rec_emit(rec_kind_t kind, int module, int tedax, int bench, int arg) {
+    if (atomic_load_explicit(&rec_mode, memory_order_relaxed) == REC_OFF) return;
+    int32_t v[4] = { module, tedax, bench, arg };
+    emit_raw(kind, 0, v);
+}
+
+void rec_command(const char *cmd) {
+    if (atomic_load_explicit(&rec_mode, memory_order_relaxed) == REC_OFF) return;
+    int len = (int)strlen(cmd);
+    for (int off = 0; off == 0 || off < len; off += REC_TEXT_BYTES) {
+        char chunk[REC_TEXT_BYTES] = {0};
+        int n = len - off < REC_TEXT_BYTES ? len - off : REC_TEXT_BYTES;
+        memcpy(chunk, cmd + off, (size_t)n);
+        emit_raw(off == 0 ? REC_CMD : REC_CMD_MORE, off == 0 ? len : n, chunk);
+    }
+}
+
+static int in_round(int i) { return i >= rp_lo && i < rp_hi; }
+
+unsigned int rec_rng(rec_rng_site_t site, int owner, unsigned int drawn) {
+    int mode = atomic_load_explicit(&rec_mode, memory_order_relaxed);
+    if (mode == REC_OFF) return drawn;
+    if (owner < 0 || owner >= LOADGEN_MAX_PRODUCERS) owner = -1;
+    if (mode == REC_REPLAYING) {
+        int *cur = &rp_rng_cur[site][owner < 0 ? 0 : owner];
+        int i = *cur;
+        while (in_round(i) && !(rp_log[i].kind == REC_RNG && rp_log[i].u.v.tedax == (int)site &&
+                                rp_log[i].u.v.bench == owner)) i++;
+        if (in_round(i)) {
+            drawn = (unsigned int)rp_log[i].u.v.arg;
+            *cur = i + 1;
+        } else {
+            rp_rng_short++;
+        }
+    }
+    rec_emit(REC_RNG, -1, site, owner, (int)drawn);
+    return drawn;
+}
+
+void rec_round_begin(int difficulty, int policy, unsigned int seed) {
+    if (atomic_load_explicit(&rec_mode, memory_order_relaxed) == REC_OFF) return;
+    rp_start_ns = sim_now_ns();
+    rec_emit(REC_ROUND, difficulty, policy, atomic_fetch_add(&rounds_recorded, 1), (int)seed);
+}
+
+void rec_round_end(int score, int generated) {
+    rec_emit(REC_ROUND_END, generated, -1, -1, score);
+}
+
+// =====================================================
+//  Replay: leitura
+// =====================================================
+int rec_replay_open(const char *path, rec_config_t *cfg) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { fprintf(stderr, "replay: nao foi possivel abrir '%s'\n", path); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < REC_HEADER_BYTES) {
+        fprintf(stderr, "replay: '%s' nao e uma gravacao\n", path);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const rec_header_t *h = map;
+    uint64_t capacity = h->capacity;
+    if (memcmp(h->magic, REC_MAGIC, sizeof(h->magic)) != 0 || h->version != REC_VERSION ||
+        h->entry_size != sizeof(rec_entry_t) || capacity == 0 || (capacity & (capacity - 1)) ||
+        REC_HEADER_BYTES + capacity * sizeof(rec_entry_t) > (uint64_t)st.st_size) {
+        fprintf(stderr, "replay: '%s' nao e uma gravacao compativel\n", path);
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+    const rec_entry_t *ring = (const rec_entry_t*)((const char*)map + REC_HEADER_BYTES);
+    uint64_t head = atomic_load(&((rec_header_t*)map)->head);
+    uint64_t first = head > capacity ? head - capacity : 0;
+
+    rec_replay_close();
+    rp_cfg = h->cfg;
+    rp_log = malloc((size_t)(head - first + 1) * sizeof(rec_entry_t));
+    rp_round_at = malloc((size_t)(head - first + 1) * sizeof(int));
+    if (!rp_log || !rp_round_at) { munmap(map, (size_t)st.st_size); rec_replay_close(); return -1; }
+
+    int torn = 0;
+    for (uint64_t t = first; t < head; ++t) {
+        const rec_entry_t *e = &ring[t & (capacity - 1)];
+        if (e->commit != (uint32_t)(t + 1) || e->kind >= REC_KIND_COUNT) { torn++; continue; }
+        // o começo do anel pode ter sido sobrescrito: só rodadas inteiras
+        if (e->kind == REC_ROUND) rp_round_at[rp_rounds++] = rp_n;
+        else if (rp_rounds == 0) continue;
+        rp_log[rp_n++] = *e;
+    }
+    munmap(map, (size_t)st.st_size);
+    if (first > 0) fprintf(stderr, "replay: anel deu a volta, %llu registros antigos perdidos\n",
+                           (unsigned long long)first);
+    if (torn) fprintf(stderr, "replay: %d registros incompletos ignorados\n", torn);
+    if (cfg) *cfg = rp_cfg;
+    atomic_store(&rec_mode, REC_REPLAYING);
+    return 0;
+}
+
+void rec_replay_close(void) {
+    if (rec_replaying()) atomic_store(&rec_mode, REC_OFF);
+    free(rp_log); rp_log = NULL; rp_n = 0;
+    free(rp_round_at); rp_round_at = NULL; rp_rounds = 0;
+    free(cap); cap = NULL; cap_n = cap_size = 0;
+}
+
+int rec_replay_rounds(void) { return rp_rounds; }
+int rec_replay_producers(void) { return rp_producers; }
+
+int rec_replay_select(int round, rec_round_info_t *info) {
+    if (round < 0 || round >= rp_rounds) return -1;
+    rp_lo = rp_round_at[round];
+    rp_hi = round + 1 < rp_rounds ? rp_round_at[round + 1] : rp_n;
+    const rec_entry_t *r = &rp_log[rp_lo];
+    rp_round_ts = r->ts_ns;
+
+    int complete = 0;
+    rp_producers = 0;
+    for (int i = rp_lo; i < rp_hi; ++i) {
+        // eventos depois do fim da rodada (threads terminando) ficam de fora
+        if (rp_log[i].kind == REC_ROUND_END) { rp_hi = i + 1; complete = 1; break; }
+        if (rp_log[i].kind == REC_GEN && rp_log[i].u.v.tedax >= rp_producers)
+            rp_producers = rp_log[i].u.v.tedax + 1;
+    }
+    if (rp_producers > LOADGEN_MAX_PRODUCERS) rp_producers = LOADGEN_MAX_PRODUCERS;
+    for (int p = 0; p < LOADGEN_MAX_PRODUCERS; ++p) rp_gen_cur[p] = rp_lo;
+    for (int s = 0; s < REC_RNG_SITES; ++s)
+        for (int o = 0; o < LOADGEN_MAX_PRODUCERS; ++o) rp_rng_cur[s][o] = rp_lo;
+    rp_cmd_cur = rp_lo;
+    rp_rng_short = 0;
+    cap_n = 0;
+    atomic_store(&rounds_recorded, r->u.v.bench);   // REC_ROUND do replay repete o número
+
+    if (info) {
+        info->difficulty = r->u.v.module;
+        info->policy = r->u.v.tedax;
+        info->seed = (unsigned int)r->u.v.arg;
+        info->complete = complete;
+    }
+    return 0;
+}
+
+// atraso (ms, arredondado para cima) até o instante gravado do registro i
+static long long delay_until(int i) {
+    long long at = rp_start_ns + (rp_log[i].ts_ns - rp_round_ts);
+    long long d = at - sim_now_ns();
+    return d > 0 ? (d + 999999) / 1000000 : 0;
+}
+
+static int seek_gen(int producer) {
+    int i = rp_gen_cur[producer];
+    while (in_round(i) && !(rp_log[i].kind == REC_GEN && rp_log[i].u.v.tedax == producer)) i++;
+    rp_gen_cur[producer] = i;
+    return in_round(i) ? i : -1;
+}
+
+long long rec_replay_gen_delay_ms(int producer) {
+    if (producer < 0 || producer >= rp_producers) return -1;
+    int i = seek_gen(producer);
+    return i < 0 ? -1 : delay_until(i);
+}
+
+int rec_replay_next_gen(int producer, rec_gen_t *out) {
+    if (producer < 0 || producer >= rp_producers) return 0;
+    int i = seek_gen(producer);
+    if (i < 0) return 0;
+    out->id = rp_log[i].u.v.module;
+    out->producer = producer;
+    out->timeout_ms = rp_log[i].u.v.bench;
+    out->type = rp_log[i].u.v.arg;
+    rp_gen_cur[producer] = i + 1;
+    return 1;
+}
+
+static int seek_cmd(void) {
+    int i = rp_cmd_cur;
+    while (in_round(i) && rp_log[i].kind != REC_CMD) i++;
+    rp_cmd_cur = i;
+    return in_round(i) ? i : -1;
+}
+
+long long rec_replay_cmd_delay_ms(void) {
+    int i = seek_cmd();
+    return i < 0 ? -1 : delay_until(i);
+}
+
+int rec_replay_next_cmd(char *buf, int len) {
+    int i = seek_cmd();
+    if (i < 0 || len <= 0) return 0;
+    int total = rp_log[i].len, got = 0;
+    for (int j = i; in_round(j) && got < total; ++j) {
+        if (j > i && rp_log[j].kind != REC_CMD_MORE) continue;
+        int n = j == i ? (total < REC_TEXT_BYTES ? total : REC_TEXT_BYTES) : rp_log[j].len;
+        for (int k = 0; k < n && got < len - 1; ++k) buf[got++] = rp_log[j].u.text[k];
+        if (got >= len - 1) break;
+    }
+    buf[got] = '\0';
+    rp_cmd_cur = i + 1;
+    return 1;
+}
+
+long long rec_replay_end_ms(void) {
+    if (rp_hi <= rp_lo || rp_log[rp_hi - 1].kind != REC_ROUND_END) return -1;
+    return (rp_log[rp_hi - 1].ts_ns - rp_round_ts) / 1000000;
+}
+
+// =====================================================
+//  Replay: verificação
+// =====================================================
+static void describe(const rec_entry_t *e, long long base_ns, char *buf, int len) {
+    const char *name = e->kind < REC_KIND_COUNT ? kind_names[e->kind] : "?";
+    double t_ms = (double)(e->ts_ns - base_ns) / 1e6;
+    if (e->kind == REC_CMD || e->kind == REC_CMD_MORE) {
+        snprintf(buf, len, "%s \"%.*s\" t=%.3fms", name, REC_TEXT_BYTES, e->u.text, t_ms);
+    } else {
+        snprintf(buf, len, "%s M%d T%d B%d arg=%d t=%.3fms", name,
+                 e->u.v.module, e->u.v.tedax, e->u.v.bench, e->u.v.arg, t_ms);
+    }
+}
+
+int rec_replay_verify(char *why, int len) {
+    int expected = rp_hi - rp_lo;
+    int got = cap_n;
+    for (int i = 0; i < cap_n; ++i) {
+        if (cap[i].kind == REC_ROUND_END) { got = i + 1; break; }
+    }
+    long long cap_base = got > 0 ? cap[0].ts_ns : 0;
+    // gravações do jogo com threads estão em tempo real: só a ordem e o conteúdo contam
+    int check_time = !rp_cfg.live;
+
+    int n = expected < got ? expected : got;
+    for (int i = 0; i < n; ++i) {
+        const rec_entry_t *a = &rp_log[rp_lo + i], *b = &cap[i];
+        int same = a->kind == b->kind && a->len == b->len &&
+                   memcmp(a->u.text, b->u.text, REC_TEXT_BYTES) == 0 &&
+                   (!check_time || a->ts_ns - rp_round_ts == b->ts_ns - cap_base);
+        if (!same) {
+            char ea[128], eb[128];
+            describe(a, rp_round_ts, ea, sizeof(ea));
+            describe(b, cap_base, eb, sizeof(eb));
+            snprintf(why, len, "evento %d: gravado %s, replay %s", i, ea, eb);
+            return 0;
+        }
+    }
+    if (expected != got) {
+        snprintf(why, len, "%d eventos gravados, %d no replay", expected, got);
+        return 0;
+    }
+    if (rp_rng_short) {
+        snprintf(why, len, "%d sorteios alem dos gravados", rp_rng_short);
+        return 0;
+    }
+    snprintf(why, len, "%d eventos identicos", expected);
+    return 1;
+}
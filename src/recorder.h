@@ -0,0 +1,114 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+// Gravador binário de partidas (ksne --record ARQ) e replay (--replay ARQ).
+// Cada evento vira um registro de 32 bytes num anel mapeado em memória
+// (mmap de um arquivo): gravar é um fetch_add e algumas stores, sem
+// syscall nem lock, e o que já foi escrito sobrevive a um crash do
+// processo. O anel guarda os REC_CAPACITY registros mais recentes.
+//
+// O replay roda a partida de novo no relógio virtual (--sim), usando como
+// entrada as chegadas e os comandos gravados e, no lugar do gerador, os
+// sorteios gravados. Os eventos produzidos são capturados e comparados
+// com os da gravação: uma partida gravada no modo headless é reproduzida
+// bit a bit; numa gravação do jogo com threads, a primeira divergência
+// aponta onde a ordem entre threads mudou o resultado.
+
+typedef enum {
+    REC_ROUND = 0,      // início de rodada: M = dificuldade, T = política, B = nº da rodada, arg = semente
+    REC_ROUND_END,      // M = módulos gerados, arg = score
+    REC_GEN,            // M, T = produtor, B = prazo (ms), arg = tipo pedido (-1 = sorteio do mural)
+    REC_PUSH,           // M entrou no mural
+    REC_REQUEUE,        // M voltou ao mural
+    REC_TIMEOUT,        // M venceu esperando no mural
+    REC_CMD,            // comando executado: texto (len = tamanho total), continua em REC_CMD_MORE
+    REC_CMD_MORE,
+    REC_ASSIGN,         // M, T, B, arg = duração sorteada da tentativa (ms)
+    REC_BENCH_ACQ,      // B
+    REC_BENCH_REL,      // B
+    REC_OUTCOME,        // M, T, B, arg = rec_outcome_t
+    REC_RNG,            // T = rec_rng_site_t, B = produtor dono do fluxo (-1 = fila única), arg = valor sorteado
+    REC_KIND_COUNT
+} rec_kind_t;
+
+typedef enum { REC_OUT_FAILED = 0, REC_OUT_DISARMED, REC_OUT_EXPLODED } rec_outcome_t;
+
+// Pontos do código que sorteiam (cada um tem sua fila no replay; o
+// conteúdo dos módulos, uma por produtor)
+typedef enum {
+    REC_RNG_MODULE = 0,   // conteúdo do módulo (create_module_of_type)
+    REC_RNG_ATTEMPT,      // duração da tentativa
+    REC_RNG_AI,           // sucesso da tentativa automática
+    REC_RNG_SITES
+} rec_rng_site_t;
+
+#define REC_TEXT_BYTES 16
+
+typedef struct {
+    int64_t ts_ns;                  // relógio do jogo (virtual no --sim)
+    uint16_t kind;
+    uint16_t len;                   // REC_CMD: tamanho total do texto
+    union {
+        struct { int32_t module, tedax, bench, arg; } v;
+        char text[REC_TEXT_BYTES];
+    } u;
+    uint32_t commit;                // (ticket + 1): escrito por último
+} rec_entry_t;
+
+// Configuração da sessão, gravada no cabeçalho do arquivo
+typedef struct {
+    int32_t live;               // 1 = jogo com threads, 0 = --headless --sim
+    int32_t autopilot;          // live: piloto automático do coordenador
+    int32_t bot_interval_ms;    // headless: 0 = despacho a cada evento
+    int32_t tedax, benches;     // --tedax / --benches (0 = da dificuldade)
+    uint32_t seed;
+    int32_t bombs;              // --bombs/--bomb (0 = modo clássico)
+    int32_t bomb_weight[MURAL_MAX_BOMBS];
+    int32_t bomb_duration_sec[MURAL_MAX_BOMBS];
+    int32_t bomb_gen_interval_ms[MURAL_MAX_BOMBS];
+} rec_config_t;
+
+// Gravação
+int rec_open(const char *path, const rec_config_t *cfg);   // 0 ou -1
+void rec_close(void);
+int rec_recording(void);
+void rec_emit(rec_kind_t kind, int module, int tedax, int bench, int arg);
+void rec_command(const char *cmd);
+unsigned int rec_rng(rec_rng_site_t site, int owner, unsigned int drawn);   // no replay devolve o gravado
+void rec_round_begin(int difficulty, int policy, unsigned int seed);
+void rec_round_end(int score, int generated);
+
+// Replay
+typedef struct {
+    int difficulty;
+    int policy;
+    unsigned int seed;
+    int complete;               // tem REC_ROUND_END
+} rec_round_info_t;
+
+typedef struct {
+    int id, producer, type, timeout_ms;
+} rec_gen_t;
+
+int rec_replay_open(const char *path, rec_config_t *cfg);  // 0 ou -1 (mensagem no stderr)
+void rec_replay_close(void);
+int rec_replaying(void);
+int rec_replay_rounds(void);
+int rec_replay_select(int round, rec_round_info_t *info);  // prepara a captura da rodada
+int rec_replay_producers(void);
+
+// Entradas da rodada: atraso até a próxima (-1 = acabaram) e consumo
+long long rec_replay_gen_delay_ms(int producer);
+int rec_replay_next_gen(int producer, rec_gen_t *out);
+long long rec_replay_cmd_delay_ms(void);
+int rec_replay_next_cmd(char *buf, int len);
+long long rec_replay_end_ms(void);     // duração gravada da rodada (-1 se incompleta)
+
+// Compara a captura com a gravação; 1 = idêntica. why recebe a primeira divergência.
+int rec_replay_verify(char *why, int len);
+
+#endif // RECORDER_H
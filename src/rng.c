@@ -0,0 +1,48 @@
+#include "rng.h"
+
+#include <stdatomic.h>
+
+static atomic_ullong master_seed = 1;
+
+// splitmix64: espalha (semente, fluxo) pelos 256 bits de estado
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void rng_seed(rng_t *r, uint64_t master, uint64_t stream) {
+    uint64_t x = master;
+    uint64_t mixed = splitmix64(&x) ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int i = 0; i < 4; ++i) r->s[i] = splitmix64(&mixed);
+}
+
+uint64_t rng_next64(rng_t *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+uint32_t rng_next32(rng_t *r) {
+    return (uint32_t)(rng_next64(r) >> 32);
+}
+
+double rng_uniform01(rng_t *r) {
+    // 53 bits de mantissa, deslocados meio passo: nunca 0 nem 1
+    return ((double)(rng_next64(r) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+void rng_set_master(uint64_t seed) { atomic_store(&master_seed, seed); }
+uint64_t rng_master(void) { return atomic_load(&master_seed); }
@@ -0,0 +1,33 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Gerador pseudoaleatório do jogo (xoshiro256**). Cada dono de sorteios
+// tem o próprio estado: cada produtor de carga (chegadas e, num fluxo à
+// parte, o conteúdo dos seus módulos) e cada tedax. Um estado só é usado
+// pela thread do dono, então não há lock, e a sequência de um dono não
+// depende de quem mais sorteou antes.
+//
+// Os estados derivam de uma semente mestre (--seed) e de um número de
+// fluxo fixo por dono: a mesma semente reproduz os mesmos sorteios.
+
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+// Números de fluxo (somados ao índice do dono)
+#define RNG_STREAM_MURAL     1ULL      // conteúdo dos módulos, por produtor
+#define RNG_STREAM_PRODUCER  0x100ULL
+#define RNG_STREAM_TEDAX     0x10000ULL
+
+void rng_seed(rng_t *r, uint64_t master, uint64_t stream);
+uint64_t rng_next64(rng_t *r);
+uint32_t rng_next32(rng_t *r);
+double rng_uniform01(rng_t *r);     // em (0, 1)
+
+// Semente mestre da rodada (os tedax são semeados com ela no tedax_pool_init)
+void rng_set_master(uint64_t seed);
+uint64_t rng_master(void);
+
+#endif // RNG_H
@@ -0,0 +1,128 @@
+#define _POSIX_C_SOURCE 200809L
+#include "sim.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+// O relógio virtual começa longe do zero para que "deadline == 0"
+// continue significando "timer não configurado" no mural.
+#define SIM_EPOCH_MS 3600000LL
+
+static int sim_enabled = 0;
+static long long sim_clock_ms = SIM_EPOCH_MS;
+static unsigned long long sim_seq = 0;
+
+// Min-heap de eventos ordenado por (at_ms, seq)
+static sim_event_t *heap = NULL;
+static int heap_len = 0;
+static int heap_cap = 0;
+
+// =====================================================
+//  Relógio
+// =====================================================
+void sim_enable(int on) { sim_enabled = on; }
+int sim_is_enabled(void) { return sim_enabled; }
+
+long long sim_now_ns(void) {
+    if (!sim_enabled) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+    return sim_clock_ms * 1000000LL;
+}
+
+long long sim_now_ms(void) {
+    if (!sim_enabled) return sim_now_ns() / 1000000;
+    return sim_clock_ms;
+}
+
+long long sim_wall_ms(void) {
+    if (!sim_enabled) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+    return sim_clock_ms;
+}
+
+void sim_cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+void sim_abs_timespec(long long at_ms, struct timespec *ts) {
+    if (at_ms < 0) at_ms = 0;
+    ts->tv_sec = (time_t)(at_ms / 1000);
+    ts->tv_nsec = (long)(at_ms % 1000) * 1000000L;
+}
+
+// =====================================================
+//  Fila de eventos
+// =====================================================
+static int ev_before(const sim_event_t *a, const sim_event_t *b) {
+    if (a->at_ms != b->at_ms) return a->at_ms < b->at_ms;
+    return a->seq < b->seq;
+}
+
+static void ev_swap(int i, int j) {
+    sim_event_t t = heap[i]; heap[i] = heap[j]; heap[j] = t;
+}
+
+void sim_reset(void) {
+    heap_len = 0;
+    sim_seq = 0;
+    sim_clock_ms = SIM_EPOCH_MS;
+}
+
+int sim_schedule(long long at_ms, int kind, int arg) {
+    if (heap_len == heap_cap) {
+        int ncap = heap_cap ? heap_cap * 2 : 64;
+        sim_event_t *n = realloc(heap, (size_t)ncap * sizeof(sim_event_t));
+        if (!n) return -1;
+        heap = n; heap_cap = ncap;
+    }
+    if (at_ms < sim_clock_ms) at_ms = sim_clock_ms; // nunca agenda no passado
+    int i = heap_len++;
+    heap[i].at_ms = at_ms;
+    heap[i].seq = sim_seq++;
+    heap[i].kind = kind;
+    heap[i].arg = arg;
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (!ev_before(&heap[i], &heap[p])) break;
+        ev_swap(i, p);
+        i = p;
+    }
+    return 0;
+}
+
+int sim_schedule_in(long long delay_ms, int kind, int arg) {
+    return sim_schedule(sim_clock_ms + delay_ms, kind, arg);
+}
+
+int sim_next(sim_event_t *out) {
+    if (heap_len == 0) return 0;
+    *out = heap[0];
+    heap[0] = heap[--heap_len];
+    int i = 0;
+    while (1) {
+        int l = 2 * i + 1, r = l + 1, s = i;
+        if (l < heap_len && ev_before(&heap[l], &heap[s])) s = l;
+        if (r < heap_len && ev_before(&heap[r], &heap[s])) s = r;
+        if (s == i) break;
+        ev_swap(i, s);
+        i = s;
+    }
+    sim_clock_ms = out->at_ms;
+    return 1;
+}
+
+void sim_destroy(void) {
+    free(heap);
+    heap = NULL;
+    heap_len = heap_cap = 0;
+}
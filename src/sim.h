@@ -0,0 +1,49 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <pthread.h>
+#include <time.h>
+
+// Relógio do jogo e modo de simulação discreta (ksne --headless --sim).
+// Fora da simulação o relógio é CLOCK_MONOTONIC (imune a ajustes da hora
+// do sistema); com a simulação ativa, todo o tempo vem de um relógio
+// virtual que só avança quando o próximo evento da fila é consumido.
+// Prazos e durações do jogo são sempre milissegundos deste relógio.
+
+typedef enum {
+    SIM_EV_GENERATE = 0,   // gerador cria um novo módulo
+    SIM_EV_EXPIRE,         // próximo prazo de módulo no mural
+    SIM_EV_TEDAX_DONE,     // tedax terminou a tentativa (arg = id do tedax)
+    SIM_EV_GAME_END,       // fim do tempo da partida
+    SIM_EV_BOT_PRESS,      // bot "aperta A" (modo headless com --bot-interval)
+    SIM_EV_REPLAY_CMD,     // replay: próximo comando gravado
+    SIM_EV_BOMB_TIMER      // timer de uma bomba (multi-bomba, arg = bomba)
+} sim_event_kind_t;
+
+typedef struct {
+    long long at_ms;          // instante virtual do evento
+    unsigned long long seq;   // desempate FIFO entre eventos simultâneos
+    int kind;
+    int arg;
+} sim_event_t;
+
+// Relógio
+void sim_enable(int on);
+int sim_is_enabled(void);
+long long sim_now_ns(void);
+long long sim_now_ms(void);   // base de todos os prazos do jogo
+long long sim_wall_ms(void);  // hora de parede, só para exibição (log)
+
+// Esperas com prazo absoluto no relógio do jogo: condições criadas com
+// sim_cond_init aceitam o timespec de sim_abs_timespec em pthread_cond_timedwait
+void sim_cond_init(pthread_cond_t *cond);
+void sim_abs_timespec(long long at_ms, struct timespec *ts);
+
+// Fila de eventos (single-thread: usada apenas pelo laço da simulação)
+void sim_reset(void);
+int sim_schedule(long long at_ms, int kind, int arg);
+int sim_schedule_in(long long delay_ms, int kind, int arg);
+int sim_next(sim_event_t *out); // retira o próximo evento e avança o relógio (0 se vazia)
+void sim_destroy(void);
+
+#endif // SIM_H
@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200809L
+#include "slab.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SLAB_CHUNK_OBJS 256            // objetos por bloco
+#define SLAB_MAX_CHUNKS 4096           // teto: ~1M objetos por pool
+#define SLAB_HDR 16                    // cabeçalho com o índice do objeto
+#define SLAB_NIL 0xffffffffu
+
+typedef struct {
+    atomic_uint next[SLAB_CHUNK_OBJS]; // encadeamento da lista de livres
+    unsigned char *objs;
+} slab_chunk_t;
+
+struct slab {
+    size_t stride;                     // cabeçalho + objeto, alinhado a 16
+    size_t obj_size;
+    slab_chunk_t *chunks[SLAB_MAX_CHUNKS];
+    atomic_uint nchunks;
+    atomic_uint_fast64_t free_head;    // (etiqueta << 32) | índice
+    atomic_size_t in_use;
+    pthread_mutex_t grow_lock;
+};
+
+static unsigned char* slot_of(const slab_t *s, unsigned idx) {
+    slab_chunk_t *c = s->chunks[idx / SLAB_CHUNK_OBJS];
+    return c->objs + (size_t)(idx % SLAB_CHUNK_OBJS) * s->stride;
+}
+
+static atomic_uint* next_of(slab_t *s, unsigned idx) {
+    return &s->chunks[idx / SLAB_CHUNK_OBJS]->next[idx % SLAB_CHUNK_OBJS];
+}
+
+static void push_free(slab_t *s, unsigned idx) {
+    uint_fast64_t old = atomic_load(&s->free_head);
+    uint_fast64_t nw;
+    do {
+        atomic_store_explicit(next_of(s, idx), (unsigned)(old & 0xffffffffu), memory_order_relaxed);
+        nw = ((old >> 32) + 1) << 32 | idx;
+    } while (!atomic_compare_exchange_weak(&s->free_head, &old, nw));
+}
+
+static int pop_free(slab_t *s, unsigned *out) {
+    uint_fast64_t old = atomic_load(&s->free_head);
+    uint_fast64_t nw;
+    do {
+        unsigned idx = (unsigned)(old & 0xffffffffu);
+        if (idx == SLAB_NIL) return 0;
+        // se outro thread já retirou idx, a etiqueta mudou e o CAS falha
+        unsigned next = atomic_load_explicit(next_of(s, idx), memory_order_relaxed);
+        nw = ((old >> 32) + 1) << 32 | next;
+    } while (!atomic_compare_exchange_weak(&s->free_head, &old, nw));
+    *out = (unsigned)(old & 0xffffffffu);
+    return 1;
+}
+
+// adiciona um bloco e empilha todos os seus objetos (0 se no teto ou sem memória)
+static int grow(slab_t *s) {
+    pthread_mutex_lock(&s->grow_lock);
+    // outro thread pode ter crescido enquanto esperávamos
+    if ((atomic_load(&s->free_head) & 0xffffffffu) != SLAB_NIL) {
+        pthread_mutex_unlock(&s->grow_lock);
+        return 1;
+    }
+    unsigned n = atomic_load(&s->nchunks);
+    if (n >= SLAB_MAX_CHUNKS) { pthread_mutex_unlock(&s->grow_lock); return 0; }
+    slab_chunk_t *c = malloc(sizeof(slab_chunk_t));
+    unsigned char *objs = c ? malloc(s->stride * SLAB_CHUNK_OBJS) : NULL;
+    if (!objs) { free(c); pthread_mutex_unlock(&s->grow_lock); return 0; }
+    c->objs = objs;
+    s->chunks[n] = c;
+    for (unsigned i = 0; i < SLAB_CHUNK_OBJS; ++i) {
+        unsigned idx = n * SLAB_CHUNK_OBJS + i;
+        atomic_init(&c->next[i], SLAB_NIL);
+        memcpy(objs + (size_t)i * s->stride, &idx, sizeof(idx));
+    }
+    atomic_store(&s->nchunks, n + 1);
+    for (unsigned i = SLAB_CHUNK_OBJS; i-- > 0; ) push_free(s, n * SLAB_CHUNK_OBJS + i);
+    pthread_mutex_unlock(&s->grow_lock);
+    return 1;
+}
+
+slab_t* slab_create(size_t obj_size) {
+    slab_t *s = calloc(1, sizeof(slab_t));
+    if (!s) return NULL;
+    s->obj_size = obj_size;
+    s->stride = (SLAB_HDR + obj_size + 15) & ~(size_t)15;
+    atomic_init(&s->nchunks, 0);
+    atomic_init(&s->free_head, SLAB_NIL);
+    atomic_init(&s->in_use, 0);
+    pthread_mutex_init(&s->grow_lock, NULL);
+    return s;
+}
+
+void slab_destroy(slab_t *s) {
+    if (!s) return;
+    unsigned n = atomic_load(&s->nchunks);
+    for (unsigned i = 0; i < n; ++i) {
+        free(s->chunks[i]->objs);
+        free(s->chunks[i]);
+    }
+    pthread_mutex_destroy(&s->grow_lock);
+    free(s);
+}
+
+void slab_reset(slab_t *s) {
+    if (!s) return;
+    // refaz a lista na ordem de um pool novo: índice 0 sai primeiro
+    unsigned total = atomic_load(&s->nchunks) * SLAB_CHUNK_OBJS;
+    for (unsigned i = 0; i < total; ++i)
+        atomic_store_explicit(next_of(s, i), i + 1 < total ? i + 1 : SLAB_NIL, memory_order_relaxed);
+    uint_fast64_t tag = (atomic_load(&s->free_head) >> 32) + 1;
+    atomic_store(&s->free_head, tag << 32 | (total ? 0 : SLAB_NIL));
+    atomic_store(&s->in_use, 0);
+}
+
+void* slab_alloc(slab_t *s) {
+    unsigned idx;
+    while (!pop_free(s, &idx)) {
+        if (!grow(s)) return NULL;
+    }
+    atomic_fetch_add(&s->in_use, 1);
+    void *obj = slot_of(s, idx) + SLAB_HDR;
+    memset(obj, 0, s->obj_size);
+    return obj;
+}
+
+void slab_free(slab_t *s, void *obj) {
+    if (!s || !obj) return;
+    unsigned idx;
+    memcpy(&idx, (unsigned char*)obj - SLAB_HDR, sizeof(idx));
+    atomic_fetch_sub(&s->in_use, 1);
+    push_free(s, idx);
+}
+
+size_t slab_capacity(const slab_t *s) {
+    return (size_t)atomic_load(&((slab_t*)s)->nchunks) * SLAB_CHUNK_OBJS;
+}
+
+size_t slab_in_use(const slab_t *s) {
+    return atomic_load(&((slab_t*)s)->in_use);
+}
@@ -0,0 +1,23 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+// Pool de objetos de tamanho fixo, alocados em blocos ("slabs").
+// A lista de livres é uma pilha de Treiber sem lock (índice + etiqueta
+// anti-ABA num único inteiro de 64 bits); só o crescimento usa mutex.
+// A memória só volta ao sistema em slab_destroy.
+
+typedef struct slab slab_t;
+
+slab_t* slab_create(size_t obj_size);
+void slab_destroy(slab_t *s);
+void slab_reset(slab_t *s);           // todos os objetos voltam a livres (sem usuários concorrentes)
+
+void* slab_alloc(slab_t *s);          // objeto zerado, ou NULL se esgotado
+void slab_free(slab_t *s, void *obj);
+
+size_t slab_capacity(const slab_t *s); // objetos já reservados em blocos
+size_t slab_in_use(const slab_t *s);
+
+#endif // SLAB_H
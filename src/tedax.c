@@ -1,16 +1,24 @@
 #define _POSIX_C_SOURCE 200809L
 #include "tedax.h"
 #include "mural.h"
-#include "ui.h"         
+#include "eventlog.h"
+#include "ui.h"
 #include "config.h"
+#include "sim.h"
+#include "coordinator.h"
+#include "metrics.h"
+#include "lockprof.h"
+#include "recorder.h"
+#include "park.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
-#include <semaphore.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <ctype.h>
 
 // pool
@@ -18,18 +26,55 @@ static tedax_t *pool = NULL;
 static int pool_n = 0;
 static volatile int pool_running = 0;
 
-// benches bookkeeping
+// benches bookkeeping: um único bitmap atômico (bit = bancada ocupada).
+// Bits acima de num_benches ficam sempre ligados, então "livre" = bit 0.
 #ifdef NUM_BENCHES
 static int num_benches = NUM_BENCHES;
 #else
 static int num_benches = 2;
 #endif
-static int *bench_busy = NULL;
-static sem_t *external_benches_sem = NULL;
+static atomic_uint_fast64_t bench_bits;
+static atomic_int bench_waiters;           // tedax na fila de espera por bancada
+
+// =====================================================
+//  Escalonador: tedax lógicos sobre poucas threads
+// =====================================================
+// Um tedax é só estado (tedax_t); quem executa são TEDAX_WORKERS threads
+// (padrão: uma por núcleo). Tentativas em curso ficam num min-heap de
+// timers pelo fim planejado; tedax sem bancada ficam numa fila FIFO e
+// recebem a próxima bancada liberada. Ordem de locks: tedax.lock -> sched_mutex.
+typedef struct {
+    long long at_ms;
+    int tedax_id;
+} sched_timer_t;
+
+static pthread_mutex_t sched_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sched_cond;
+static sched_timer_t *timers = NULL;
+static int timers_len = 0;
+static int timers_cap = 0;
+static int *bench_queue = NULL;            // anel com capacidade pool_n
+static int bq_head = 0;
+// Os workers vivem entre rodadas: estacionam no tedax_pool_destroy e o
+// próximo tedax_pool_init os libera, criando só os que faltarem. Os de
+// índice >= n_workers (a rodada pede menos) estacionam logo de volta.
+static pthread_t *workers = NULL;          // todas as já criadas
+static park_t worker_park = PARK_INITIALIZER;
+static int n_workers = 0;                  // ativos na rodada
+static int requested_workers = 0;          // 0 = um por núcleo
+
+// versão do estado visível (ocupação, tempo restante, bancadas)
+static atomic_ulong tedax_ver;
+
+// módulos que explodiram na mão de um tedax desde tedax_pool_init
+static atomic_int explosions;
+// ociosidade já encerrada, somada entre os tedax (ms do relógio de espera do mural)
+static atomic_llong idle_ms_closed;
+// tedax com busy = 1 (lido sem lock pela telemetria)
+static atomic_int busy_count;
 
 // mutexes
 static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // helper: lowercase comparison
 static int ci_equal(const char *a, const char *b) {
@@ -44,166 +89,349 @@ static int ci_equal(const char *a, const char *b) {
     return *a == '\0' && *b == '\0';
 }
 
-// acquire a free bench index (returns index or -1)
-static int bench_acquire_index_blocking(void) {
-    if (external_benches_sem) sem_wait(external_benches_sem);
+static void tedax_changed(void) {
+    atomic_fetch_add(&tedax_ver, 1);
+    ui_wake();
+}
 
-    int idx = -1;
-    while (1) {
-        pthread_mutex_lock(&bench_mutex);
-        for (int i = 0; i < num_benches; ++i) {
-            if (!bench_busy[i]) {
-                bench_busy[i] = 1;
-                idx = i;
-                break;
-            }
-        }
-        pthread_mutex_unlock(&bench_mutex);
-        if (idx >= 0) return idx;
-        
-        struct timespec ts;
-        ts.tv_sec = 0;
-        ts.tv_nsec = 100 * 1000000; // 100ms
-        nanosleep(&ts, NULL);
+unsigned long tedax_version(void) { return atomic_load(&tedax_ver); }
+int tedax_explosion_count(void) { return atomic_load(&explosions); }
+
+// Ociosidade medida no relógio de espera do mural: só conta o tempo em
+// que havia módulo esperando. Tedax parado com o mural vazio não é
+// capacidade desperdiçada, e a soma passa a depender da política
+long long tedax_idle_ms(void) {
+    long long total = atomic_load(&idle_ms_closed);
+    long long now = mural_waiting_ms();
+    for (int i = 0; i < pool_n; ++i) {
+        LOCK(&pool[i].lock);
+        if (pool[i].idle_mark_ms >= 0) total += now - pool[i].idle_mark_ms;
+        UNLOCK(&pool[i].lock);
     }
+    return total;
+}
+
+static void bench_reset(int count) {
+    uint_fast64_t bits = 0;
+    if (count < TEDAX_MAX_BENCHES) bits = ~(((uint_fast64_t)1 << count) - 1);
+    atomic_store(&bench_bits, bits);
 }
 
+// tenta reservar a bancada livre de menor índice (retorna índice ou -1)
 static int bench_try_acquire_index(void) {
-    pthread_mutex_lock(&bench_mutex);
-    int idx = -1;
-    for (int i = 0; i < num_benches; ++i) {
-        if (!bench_busy[i]) {
-            bench_busy[i] = 1;
-            idx = i;
-            break;
+    uint_fast64_t old = atomic_load(&bench_bits);
+    for (;;) {
+        uint_fast64_t free_bits = ~old;
+        if (!free_bits) return -1;
+        int idx = __builtin_ctzll((unsigned long long)free_bits);
+        if (atomic_compare_exchange_weak(&bench_bits, &old, old | ((uint_fast64_t)1 << idx))) {
+            rec_emit(REC_BENCH_ACQ, -1, -1, idx, 0);
+            tedax_changed();
+            return idx;
         }
     }
-    pthread_mutex_unlock(&bench_mutex);
-    return idx;
 }
 
+// reserva uma bancada específica (reserva manual); 1 ok / 0 ocupada
+static int bench_try_acquire_specific(int idx) {
+    if (idx < 0 || idx >= num_benches) return 0;
+    uint_fast64_t bit = (uint_fast64_t)1 << idx;
+    if (atomic_fetch_or(&bench_bits, bit) & bit) return 0;
+    rec_emit(REC_BENCH_ACQ, -1, -1, idx, 0);
+    tedax_changed();
+    return 1;
+}
+
+static void bench_handoff(void);
+
 static void bench_release_index(int idx) {
     if (idx < 0 || idx >= num_benches) return;
-    pthread_mutex_lock(&bench_mutex);
-    bench_busy[idx] = 0;
-    pthread_mutex_unlock(&bench_mutex);
-    if (external_benches_sem) sem_post(external_benches_sem);
+    atomic_fetch_and(&bench_bits, ~((uint_fast64_t)1 << idx));
+    rec_emit(REC_BENCH_REL, -1, -1, idx, 0);
+    tedax_changed();
+    // só entra no escalonador se houver tedax esperando bancada
+    if (atomic_load(&bench_waiters) > 0) bench_handoff();
 }
 
-static void* tedax_thread_fn(void *arg) {
-    tedax_t *self = (tedax_t*)arg;
+int tedax_bench_is_busy(int idx) {
+    if (idx < 0 || idx >= num_benches) return 0;
+    return (int)((atomic_load(&bench_bits) >> idx) & 1);
+}
 
-    while (pool_running) {
-        pthread_mutex_lock(&self->lock);
-        while (!self->current && pool_running) {
-            pthread_cond_wait(&self->cond, &self->lock);
-        }
-        if (!pool_running && !self->current) {
-            pthread_mutex_unlock(&self->lock);
-            break;
-        }
+// sorteia a duração da tentativa (ms): entre metade e (tempo do módulo - 1 s)
+static int draw_attempt_ms(tedax_t *t, const module_t *m) {
+    int min_attempt = (m->time_required + 1) / 2 * 1000; // ceil
+    int max_attempt = (m->time_required - 1) * 1000;
+    if (max_attempt < 1000) max_attempt = 1000;
+    if (min_attempt < 1000) min_attempt = 1000;
+    if (max_attempt < min_attempt) max_attempt = min_attempt;
+    return min_attempt + (int)(rec_rng(REC_RNG_ATTEMPT, -1, rng_next32(&t->rng)) % (unsigned int)(max_attempt - min_attempt + 1));
+}
 
-        module_t *m = self->current;
-        self->busy = 1;
-        self->start_time = time(NULL);
-        // tentativa aleatória entre metade e (tempo do módulo - 1)
-        int min_attempt = (m->time_required + 1) / 2; // ceil
-        int max_attempt = m->time_required - 1;
-        if (max_attempt < 1) max_attempt = 1;
-        if (min_attempt < 1) min_attempt = 1;
-        if (max_attempt < min_attempt) max_attempt = min_attempt;
-        int attempt_limit = min_attempt + (rand() % (max_attempt - min_attempt + 1));
-        self->remaining = attempt_limit;
-        int assigned_bench = self->bench_id; 
-
-        pthread_mutex_unlock(&self->lock);
-
-        if (assigned_bench < 0) {
-            log_event("[T%d] aguardando bancada para M%d...", self->id, m->id);
-            assigned_bench = bench_acquire_index_blocking();
-            pthread_mutex_lock(&self->lock);
-            self->bench_id = assigned_bench;
-            pthread_mutex_unlock(&self->lock);
-            log_event("[T%d] bancada %d ocupada para M%d", self->id, assigned_bench, m->id);
-        } else {
-            log_event("[T%d] bancada %d confirmada (pre-assign) M%d", self->id, assigned_bench, m->id);
-        }
+// Começa a tentativa agora (requer t->lock). Se o prazo do módulo vence
+// antes do fim sorteado, a tentativa termina no prazo, com explosão.
+static void plan_attempt(tedax_t *t, const module_t *m) {
+    if (t->attempt_ms <= 0) t->attempt_ms = draw_attempt_ms(t, m);
+    t->start_ms = sim_now_ms();
+    t->end_ms = t->start_ms + t->attempt_ms;
+    long long deadline = m->created_ms + m->timeout_ms;
+    t->exploded = deadline < t->end_ms;
+    if (t->exploded) t->end_ms = deadline > t->start_ms ? deadline : t->start_ms;
+}
 
-        int elapsed = 0;
-        int attempt_limit_local = self->remaining;
-        while (pool_running && elapsed < attempt_limit_local) {
-            sleep(1);
-            elapsed++;
-            time_t now = time(NULL);
-            // atualiza remaining para a UI
-            pthread_mutex_lock(&self->lock);
-            self->remaining = attempt_limit_local - elapsed;
-            if (self->remaining < 0) self->remaining = 0;
-            pthread_mutex_unlock(&self->lock);
-            if (now > (m->created_at + m->timeout_secs)) {
-                log_event("[T%d] 💥 M%d EXPLODIU na mao! (Timeout)", self->id, m->id);
-                pthread_mutex_lock(&self->lock);
-                self->remaining = 0;
-                pthread_mutex_unlock(&self->lock);
-                m->instruction[0] = '\0'; // Garante falha
-                break; 
-            }
+// Fim de uma tentativa (comum à thread e à simulação):
+// decide sucesso, libera a bancada e devolve o módulo ao mural.
+static void tedax_finish(tedax_t *self, module_t *m, int assigned_bench, int elapsed_ms) {
+    int success = 0;
+    
+    // Lógica de Sucesso (Igual à anterior: Manual vs Auto)
+    if (m->instruction[0] != '\0') {
+        if (ci_equal(m->instruction, m->solution)) success = 1;
+        else success = 0;
+    } 
+    else {
+        int chance = (int)(rec_rng(REC_RNG_AI, -1, rng_next32(&self->rng)) % 100);
+        if (chance < 60) success = 1;
+        else {
+            success = 0;
+            log_record(LOG_EV_TEDAX_AI_FAILED, m->id, self->id, -1, 0);
+            metrics_inc(MET_C_AI_FAILURES);
         }
+    }
+    metrics_record_us(MET_H_SOLVE, (long long)elapsed_ms * 1000);
+    rec_emit(REC_OUTCOME, m->id, self->id, assigned_bench,
+             self->exploded ? REC_OUT_EXPLODED : success ? REC_OUT_DISARMED : REC_OUT_FAILED);
+
+    bench_release_index(assigned_bench);
 
-        int success = 0;
+    if (success) {
+        log_record(LOG_EV_TEDAX_DISARMED, m->id, self->id, assigned_bench, MOEDAS_POR_MODULO);
+        mural_add_score(m->bomb);
+        mural_add_money(MOEDAS_POR_MODULO);
         
-        // Lógica de Sucesso (Igual à anterior: Manual vs Auto)
-        if (m->instruction[0] != '\0') {
-            if (ci_equal(m->instruction, m->solution)) success = 1;
-            else success = 0;
-        } 
-        else {
-            int chance = rand() % 100;
-            if (chance < 60) success = 1;
-            else { success = 0; log_event("[T%d] IA falhou no desarmamento automatico.", self->id); }
-        }
+        // --- ALTERAÇÃO AQUI: Move para resolvidos em vez de free() ---
+        mural_add_to_resolved(m);
+        // -------------------------------------------------------------
+    } else {
+        log_record(LOG_EV_TEDAX_FAILED, m->id, self->id, assigned_bench, 0);
+        m->instruction[0] = '\0'; 
+        // Ao re-enfileirar, reduzir o tempo restante do módulo (penalidade)
+        // Calculamos uma redução baseada no tempo gasto (elapsed)
+        int reduction = elapsed_ms; // reduzir no mesmo tanto de ms gastos
+        if (reduction < 1000) reduction = 1000;
+        int new_timeout = m->timeout_ms - reduction;
+        if (new_timeout < 1000) new_timeout = 1000;
+        m->timeout_ms = new_timeout;
+        m->created_ms = sim_now_ms(); // reinicia criação para usar novo timeout
+        m->expired = 0;             // novo prazo volta a ser vigiado
+        mural_requeue(m);
+    }
+
+    LOCK(&self->lock);
+    self->current = NULL;
+    self->bench_id = -1;
+    self->busy = 0;
+    atomic_fetch_sub(&busy_count, 1);
+    self->start_ms = self->end_ms = 0;
+    self->attempt_ms = 0;
+    self->idle_mark_ms = mural_waiting_ms();
+    UNLOCK(&self->lock);
+    tedax_changed();
+    coord_notify(); // tedax e bancada livres: o piloto automático pode despachar
+}
+
+static void timer_push(long long at_ms, int tedax_id) {
+    if (timers_len == timers_cap) {
+        int ncap = timers_cap ? timers_cap * 2 : 64;
+        sched_timer_t *n = realloc(timers, (size_t)ncap * sizeof(sched_timer_t));
+        if (!n) return;
+        timers = n; timers_cap = ncap;
+    }
+    int i = timers_len++;
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (timers[p].at_ms <= at_ms) break;
+        timers[i] = timers[p];
+        i = p;
+    }
+    timers[i].at_ms = at_ms;
+    timers[i].tedax_id = tedax_id;
+    // novo primeiro prazo: alguém precisa recalcular a espera
+    if (i == 0) pthread_cond_signal(&sched_cond);
+}
+
+static int timer_pop(void) {
+    int id = timers[0].tedax_id;
+    sched_timer_t last = timers[--timers_len];
+    int i = 0;
+    while (1) {
+        int l = 2 * i + 1, r = l + 1, c = i;
+        long long best = last.at_ms;
+        if (l < timers_len && timers[l].at_ms < best) { c = l; best = timers[l].at_ms; }
+        if (r < timers_len && timers[r].at_ms < best) c = r;
+        if (c == i) break;
+        timers[i] = timers[c];
+        i = c;
+    }
+    if (timers_len > 0) timers[i] = last;
+    return id;
+}
+
+// Começa a tentativa de um tedax que já tem bancada (requer t->lock)
+static void attempt_start_locked(tedax_t *t) {
+    plan_attempt(t, t->current);
+    LOCK(&sched_mutex);
+    timer_push(t->end_ms, t->id);
+    UNLOCK(&sched_mutex);
+    tedax_changed();
+}
 
-        bench_release_index(assigned_bench);
-
-        if (success) {
-            log_event("[T%d] ✔ M%d DESARMADO (+%d Gold)", self->id, m->id, MOEDAS_POR_MODULO);
-            mural_add_score();
-            mural_add_money(MOEDAS_POR_MODULO);
-            
-            // --- ALTERAÇÃO AQUI: Move para resolvidos em vez de free() ---
-            mural_add_to_resolved(m);
-            // -------------------------------------------------------------
-        } else {
-            log_event("[T%d] ✖ M%d FALHOU — re-enfileirado", self->id, m->id);
-            m->instruction[0] = '\0'; 
-            // Ao re-enfileirar, reduzir o tempo restante do módulo (penalidade)
-            // Calculamos uma redução baseada no tempo gasto (elapsed)
-            int reduction = elapsed; // reduzir em segundos iguais ao tempo gasto
-            if (reduction <= 0) reduction = 1;
-            int new_timeout = m->timeout_secs - reduction;
-            if (new_timeout < 1) new_timeout = 1;
-            m->timeout_secs = new_timeout;
-            m->created_at = time(NULL); // reinicia criação para usar novo timeout
-            mural_requeue(m);
+// Entrega bancadas liberadas aos tedax da fila, na ordem de chegada
+static void bench_handoff(void) {
+    for (;;) {
+        LOCK(&sched_mutex);
+        int bidx = -1, id = -1;
+        if (atomic_load(&bench_waiters) > 0 && pool_running && (bidx = bench_try_acquire_index()) >= 0) {
+            id = bench_queue[bq_head];
+            bq_head = (bq_head + 1) % pool_n;
+            atomic_fetch_sub(&bench_waiters, 1);
         }
+        UNLOCK(&sched_mutex);
+        if (id < 0) return;
+
+        tedax_t *t = &pool[id];
+        LOCK(&t->lock);
+        t->bench_id = bidx;
+        metrics_record_us(MET_H_BENCH_WAIT, (sim_now_ns() - t->bench_wait_ns) / 1000);
+        log_record(LOG_EV_TEDAX_BENCH_TAKEN, t->current->id, id, bidx, 0);
+        attempt_start_locked(t);
+        UNLOCK(&t->lock);
+    }
+}
 
-        pthread_mutex_lock(&self->lock);
-        self->current = NULL;
-        self->bench_id = -1;
-        self->busy = 0;
-        self->start_time = 0;
-        self->remaining = 0;
-        pthread_mutex_unlock(&self->lock);
+// Tedax com módulo e sem bancada: pega uma livre ou entra na fila (requer t->lock)
+static void bench_wait_locked(tedax_t *t) {
+    log_record(LOG_EV_TEDAX_WAIT_BENCH, t->current->id, t->id, -1, 0);
+    t->bench_wait_ns = sim_now_ns();
+    LOCK(&sched_mutex);
+    // entra na fila antes de olhar o bitmap: quem liberar depois disso vê
+    // bench_waiters > 0 e faz o handoff. Sem ninguém à frente, tenta já.
+    int n = atomic_fetch_add(&bench_waiters, 1);
+    bench_queue[(bq_head + n) % pool_n] = t->id;
+    int bidx = n == 0 ? bench_try_acquire_index() : -1;
+    if (bidx >= 0) atomic_fetch_sub(&bench_waiters, 1); // era o único: sai da fila
+    UNLOCK(&sched_mutex);
+    if (bidx >= 0) {
+        t->bench_id = bidx;
+        metrics_record_us(MET_H_BENCH_WAIT, (sim_now_ns() - t->bench_wait_ns) / 1000);
+        log_record(LOG_EV_TEDAX_BENCH_TAKEN, t->current->id, t->id, bidx, 0);
+        attempt_start_locked(t);
     }
+}
+
+// Timer vencido: a tentativa terminou (ou o módulo explodiu)
+static void attempt_done(tedax_t *t) {
+    LOCK(&t->lock);
+    module_t *m = t->current;
+    int bench = t->bench_id;
+    int exploded = t->exploded;
+    int elapsed = (int)(t->end_ms - t->start_ms);
+    UNLOCK(&t->lock);
+    if (!m) return;
+
+    if (exploded) {
+        log_record(LOG_EV_TEDAX_EXPLODED, m->id, t->id, bench, 0);
+        atomic_fetch_add(&explosions, 1);
+        metrics_inc(MET_C_EXPLOSIONS);
+        m->instruction[0] = '\0'; // Garante falha
+    }
+    tedax_finish(t, m, bench, elapsed);
+}
 
+// Uma rodada de um worker: até o tedax_pool_shutdown (ou já de saída,
+// se a rodada usa menos workers que os criados)
+static void worker_round(int idx) {
+    LOCK(&sched_mutex);
+    while (pool_running && idx < n_workers) {
+        if (timers_len == 0) {
+            COND_WAIT(&sched_cond, &sched_mutex);
+            continue;
+        }
+        long long next = timers[0].at_ms;
+        if (next > sim_now_ms()) {
+            struct timespec until;
+            sim_abs_timespec(next, &until);
+            COND_TIMEDWAIT(&sched_cond, &sched_mutex, &until);
+            continue;
+        }
+        int id = timer_pop();
+        // mais timers vencidos: outro worker pode adiantar
+        if (timers_len > 0 && timers[0].at_ms <= next) pthread_cond_signal(&sched_cond);
+        UNLOCK(&sched_mutex);
+        attempt_done(&pool[id]);
+        LOCK(&sched_mutex);
+    }
+    UNLOCK(&sched_mutex);
+}
+
+static void* worker_fn(void *arg) {
+    int idx = (int)(long)arg;
+    do {
+        worker_round(idx);
+    } while (park_enter(&worker_park));
     return NULL;
 }
 
-void tedax_pool_init(int n, int benches_count, sem_t *benches_sem) {
+void tedax_set_workers(int n) { requested_workers = n > 0 ? n : 0; }
+int tedax_worker_count(void) { return n_workers; }
+
+// =====================================================
+//  Modo simulação: sem threads, a tentativa vira um evento
+// =====================================================
+
+// Mesmo plano da thread (plan_attempt): o evento cai no fim da tentativa
+// ou no prazo do módulo, o que vier primeiro.
+static void tedax_sim_begin(tedax_t *t) {
+    plan_attempt(t, t->current);
+    sim_schedule(t->end_ms, SIM_EV_TEDAX_DONE, t->id);
+}
+
+void tedax_sim_complete(int id) {
+    if (!pool || id < 0 || id >= pool_n) return;
+    tedax_t *t = &pool[id];
+    module_t *m = t->current;
+    if (!m) return;
+    if (t->exploded) {
+        log_record(LOG_EV_TEDAX_EXPLODED, m->id, t->id, t->bench_id, 0);
+        atomic_fetch_add(&explosions, 1);
+        metrics_inc(MET_C_EXPLOSIONS);
+        m->instruction[0] = '\0'; // Garante falha
+    }
+    tedax_finish(t, m, t->bench_id, (int)(t->end_ms - t->start_ms));
+}
+
+// Tedax acabou de receber um módulo (requer t->lock): começa a tentativa
+// se já tem bancada, senão espera uma (na simulação a bancada vem junto)
+static void tedax_kick(tedax_t *t) {
+    if (t->idle_mark_ms >= 0) {
+        atomic_fetch_add(&idle_ms_closed, mural_waiting_ms() - t->idle_mark_ms);
+        t->idle_mark_ms = -1;
+    }
+    rec_emit(REC_ASSIGN, t->current->id, t->id, t->bench_id, t->attempt_ms);
+    tedax_changed();
+    if (sim_is_enabled()) { tedax_sim_begin(t); return; }
+    if (t->bench_id >= 0) {
+        log_record(LOG_EV_TEDAX_BENCH_PRESET, t->current->id, t->id, t->bench_id, 0);
+        attempt_start_locked(t);
+    } else {
+        bench_wait_locked(t);
+    }
+}
+
+void tedax_pool_init(int n, int benches_count) {
     if (n <= 0) return;
-    pthread_mutex_lock(&pool_mutex);
+    LOCK(&pool_mutex);
 
-    external_benches_sem = benches_sem;
     pool_n = n;
     pool_running = 1;
 
@@ -215,7 +443,13 @@ void tedax_pool_init(int n, int benches_count, sem_t *benches_sem) {
         num_benches = 2;
 #endif
     }
-    bench_busy = calloc(num_benches, sizeof(int));
+    if (num_benches > TEDAX_MAX_BENCHES) num_benches = TEDAX_MAX_BENCHES;
+    bench_reset(num_benches);
+    atomic_store(&bench_waiters, 0);
+    atomic_store(&explosions, 0);
+    atomic_store(&idle_ms_closed, 0);
+    atomic_store(&busy_count, 0);
+    long long wait_ms = mural_waiting_ms();
 
     pool = calloc(pool_n, sizeof(tedax_t));
     for (int i = 0; i < pool_n; ++i) {
@@ -223,113 +457,181 @@ void tedax_pool_init(int n, int benches_count, sem_t *benches_sem) {
         pool[i].busy = 0;
         pool[i].current = NULL;
         pool[i].bench_id = -1;
-        pool[i].start_time = 0;
-        pool[i].remaining = 0;
+        pool[i].start_ms = pool[i].end_ms = 0;
+        pool[i].attempt_ms = 0;
+        pool[i].idle_mark_ms = wait_ms;
+        rng_seed(&pool[i].rng, rng_master(), RNG_STREAM_TEDAX + (uint64_t)i);
         pthread_mutex_init(&pool[i].lock, NULL);
-        pthread_cond_init(&pool[i].cond, NULL);
-        pthread_create(&pool[i].thr, NULL, tedax_thread_fn, &pool[i]);
     }
 
-    pthread_mutex_unlock(&pool_mutex);
-    log_event("[SYSTEM] Tedax pool iniciado: %d unidades, %d bancadas", pool_n, num_benches);
+    timers_len = 0;
+    bench_queue = calloc(pool_n, sizeof(int));
+    bq_head = 0;
+    n_workers = 0;
+    if (!sim_is_enabled()) {
+        static int cond_ready = 0;
+        if (!cond_ready) { sim_cond_init(&sched_cond); cond_ready = 1; } // timers no relógio monotônico
+        int want = requested_workers;
+        if (want <= 0) want = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (want <= 0) want = 1;
+        if (want > pool_n) want = pool_n;
+        // reaproveita os estacionados e cria só os que faltam
+        int have = park_threads(&worker_park);
+        if (want > have) {
+            pthread_t *grown = realloc(workers, want * sizeof(pthread_t));
+            if (grown) workers = grown;
+            else want = have;
+        }
+        n_workers = want;
+        park_open(&worker_park);
+        for (int i = have; i < want; ++i) {
+            if (park_spawn(&worker_park, &workers[i], worker_fn, (void*)(long)i) != 0) {
+                LOCK(&sched_mutex);
+                n_workers = i;
+                UNLOCK(&sched_mutex);
+                break;
+            }
+        }
+    }
+
+    UNLOCK(&pool_mutex);
+    log_event("[SYSTEM] Tedax pool iniciado: %d unidades, %d bancadas, %d workers",
+              pool_n, num_benches, n_workers);
 }
 
 int tedax_bench_count(void) {
     return num_benches;
 }
 
+int tedax_busy_count(void) {
+    return atomic_load(&busy_count);
+}
+
+int tedax_benches_busy(void) {
+    uint_fast64_t mask = num_benches >= 64 ? ~(uint_fast64_t)0 : (((uint_fast64_t)1 << num_benches) - 1);
+    return __builtin_popcountll((unsigned long long)(atomic_load(&bench_bits) & mask));
+}
+
 void tedax_pool_shutdown(void) {
+    LOCK(&sched_mutex);
     pool_running = 0;
-    if (!pool) return;
-    for (int i = 0; i < pool_n; ++i) {
-        pthread_mutex_lock(&pool[i].lock);
-        pthread_cond_signal(&pool[i].cond);
-        pthread_mutex_unlock(&pool[i].lock);
-    }
-    if (external_benches_sem) {
-        for (int i=0;i<num_benches;i++) sem_post(external_benches_sem);
-    }
+    pthread_cond_broadcast(&sched_cond);
+    UNLOCK(&sched_mutex);
 }
 
 void tedax_pool_destroy(void) {
     if (!pool) return;
-    for (int i = 0; i < pool_n; ++i) {
-        pthread_join(pool[i].thr, NULL);
-        pthread_mutex_destroy(&pool[i].lock);
-        pthread_cond_destroy(&pool[i].cond);
-    }
+    park_close(&worker_park);
+    n_workers = 0;    // os workers estacionados não leem mais nada da rodada
+    // tentativas interrompidas ficam com o módulo; o pool do mural o libera
+    free(timers);
+    timers = NULL;
+    timers_len = timers_cap = 0;
+    free(bench_queue);
+    bench_queue = NULL;
+    atomic_store(&bench_waiters, 0);
+    for (int i = 0; i < pool_n; ++i) pthread_mutex_destroy(&pool[i].lock);
     free(pool);
     pool = NULL;
     pool_n = 0;
 
-    if (bench_busy) free(bench_busy);
-    bench_busy = NULL;
+    bench_reset(0);
     log_event("[SYSTEM] Tedax pool destruido");
 }
 
+void tedax_pool_exit(void) {
+    if (park_threads(&worker_park) == 0) return;
+    park_exit(&worker_park, workers);
+    free(workers);
+    workers = NULL;
+}
+
 int tedax_assign_module(int id, module_t *m) {
     if (!pool || id < 0 || id >= pool_n || !m) return -1;
     tedax_t *t = &pool[id];
 
-    pthread_mutex_lock(&t->lock);
+    LOCK(&t->lock);
     if (t->busy || t->current) {
-        pthread_mutex_unlock(&t->lock);
+        UNLOCK(&t->lock);
+        return -1;
+    }
+    // na simulação não há fila de espera por bancada
+    int bidx = -1;
+    if (sim_is_enabled() && (bidx = bench_try_acquire_index()) < 0) {
+        UNLOCK(&t->lock);
         return -1;
     }
     t->current = m;
-    t->bench_id = -1; 
-    t->start_time = time(NULL);
-    int min_attempt = (m->time_required + 1) / 2;
-    int max_attempt = m->time_required - 1;
-    if (max_attempt < 1) max_attempt = 1;
-    if (min_attempt < 1) min_attempt = 1;
-    if (max_attempt < min_attempt) max_attempt = min_attempt;
-    int attempt_limit = min_attempt + (rand() % (max_attempt - min_attempt + 1));
-    t->remaining = attempt_limit;
+    t->bench_id = bidx; 
+    t->start_ms = t->end_ms = 0;
+    t->attempt_ms = draw_attempt_ms(t, m);
     t->busy = 1;
-    pthread_cond_signal(&t->cond);
-    pthread_mutex_unlock(&t->lock);
+    atomic_fetch_add(&busy_count, 1);
+    tedax_kick(t);
+    UNLOCK(&t->lock);
 
-    log_event("[ASSIGN] M%d → T%d", m->id, id);
+    log_record(LOG_EV_ASSIGN, m->id, id, -1, 0);
     return 0;
 }
 
-int tedax_request_auto(module_t *m) {
-    if (!m || !pool) return -1;
-
-    int chosen = -1;
-    for (int i = 0; i < pool_n; ++i) {
-        pthread_mutex_lock(&pool[i].lock);
-        int busy = pool[i].busy || (pool[i].current != NULL);
-        pthread_mutex_unlock(&pool[i].lock);
-        if (!busy) { chosen = i; break; }
+// =====================================================
+//  Reserva em lote (despacho do coordenador)
+// =====================================================
+// Marca até max tedax ociosos como ocupados (current ainda NULL, nada é
+// agendado) e toma uma bancada para cada; sobras são devolvidas.
+int tedax_reserve_idle(int *tedax_ids, int *bench_ids, int max) {
+    if (!pool || max <= 0) return 0;
+    // nunca reserva mais tedax do que há bancadas livres (tripulações grandes)
+    int free_benches = __builtin_popcountll((unsigned long long)~atomic_load(&bench_bits));
+    if (max > free_benches) max = free_benches;
+    if (max > TEDAX_MAX_BENCHES) max = TEDAX_MAX_BENCHES;
+
+    int k = 0;
+    for (int i = 0; i < pool_n && k < max; ++i) {
+        LOCK(&pool[i].lock);
+        if (!pool[i].busy && !pool[i].current) {
+            pool[i].busy = 1;
+            atomic_fetch_add(&busy_count, 1);
+            tedax_ids[k++] = i;
+        }
+        UNLOCK(&pool[i].lock);
     }
-    if (chosen < 0) return -1;
 
-    int bidx = bench_try_acquire_index();
-    if (bidx < 0) {
-        return -1;
-    }
+    int pairs = 0;
+    while (pairs < k && (bench_ids[pairs] = bench_try_acquire_index()) >= 0) pairs++;
+    for (int i = pairs; i < k; ++i) tedax_cancel_reserved(tedax_ids[i], -1);
+    return pairs;
+}
 
-    pthread_mutex_lock(&pool[chosen].lock);
-    pool[chosen].current = m;
-    pool[chosen].bench_id = bidx;
-    pool[chosen].start_time = time(NULL);
-    {
-        int min_attempt = (m->time_required + 1) / 2;
-        int max_attempt = m->time_required - 1;
-        if (max_attempt < 1) max_attempt = 1;
-        if (min_attempt < 1) min_attempt = 1;
-        if (max_attempt < min_attempt) max_attempt = min_attempt;
-        int attempt_limit = min_attempt + (rand() % (max_attempt - min_attempt + 1));
-        pool[chosen].remaining = attempt_limit;
-    }
-    pool[chosen].busy = 1;
-    pthread_cond_signal(&pool[chosen].cond);
-    pthread_mutex_unlock(&pool[chosen].lock);
+void tedax_start_reserved(int tedax_id, int bench_id, module_t *m) {
+    tedax_t *t = &pool[tedax_id];
+    LOCK(&t->lock);
+    t->current = m;
+    t->bench_id = bench_id;
+    t->start_ms = t->end_ms = 0;
+    t->attempt_ms = draw_attempt_ms(t, m);
+    t->busy = 1;
+    tedax_kick(t);
+    UNLOCK(&t->lock);
 
-    log_event("[AUTO] M%d -> T%d B%d", m->id, chosen, bidx);
-    return chosen;
+    log_record(LOG_EV_AUTO, m->id, tedax_id, bench_id, 0);
+}
+
+void tedax_cancel_reserved(int tedax_id, int bench_id) {
+    if (bench_id >= 0) bench_release_index(bench_id);
+    LOCK(&pool[tedax_id].lock);
+    pool[tedax_id].busy = 0;
+    atomic_fetch_sub(&busy_count, 1);
+    UNLOCK(&pool[tedax_id].lock);
+    tedax_changed();
+}
+
+int tedax_request_auto(module_t *m) {
+    if (!m || !pool) return -1;
+    int tid, bid;
+    if (tedax_reserve_idle(&tid, &bid, 1) == 0) return -1;
+    tedax_start_reserved(tid, bid, m);
+    return tid;
 }
 
 int tedax_request_manual(module_t *m, int tedax_id, int bench_id, int presses) {
@@ -339,40 +641,26 @@ int tedax_request_manual(module_t *m, int tedax_id, int bench_id, int presses) {
     if (tedax_id < 0 || tedax_id >= pool_n) return 0;
     if (bench_id < 0 || bench_id >= num_benches) return 0;
 
-    pthread_mutex_lock(&pool[tedax_id].lock);
+    LOCK(&pool[tedax_id].lock);
     if (pool[tedax_id].busy || pool[tedax_id].current) {
-        pthread_mutex_unlock(&pool[tedax_id].lock);
+        UNLOCK(&pool[tedax_id].lock);
         return 0;
     }
-    pthread_mutex_unlock(&pool[tedax_id].lock);
+    UNLOCK(&pool[tedax_id].lock);
 
-    int ok = 0;
-    pthread_mutex_lock(&bench_mutex);
-    if (!bench_busy[bench_id]) {
-        bench_busy[bench_id] = 1;
-        ok = 1;
-    }
-    pthread_mutex_unlock(&bench_mutex);
-    if (!ok) return 0;
+    if (!bench_try_acquire_specific(bench_id)) return 0;
 
-    pthread_mutex_lock(&pool[tedax_id].lock);
+    LOCK(&pool[tedax_id].lock);
     pool[tedax_id].current = m;
     pool[tedax_id].bench_id = bench_id;
-    pool[tedax_id].start_time = time(NULL);
-    {
-        int min_attempt = (m->time_required + 1) / 2;
-        int max_attempt = m->time_required - 1;
-        if (max_attempt < 1) max_attempt = 1;
-        if (min_attempt < 1) min_attempt = 1;
-        if (max_attempt < min_attempt) max_attempt = min_attempt;
-        int attempt_limit = min_attempt + (rand() % (max_attempt - min_attempt + 1));
-        pool[tedax_id].remaining = attempt_limit;
-    }
+    pool[tedax_id].start_ms = pool[tedax_id].end_ms = 0;
+    pool[tedax_id].attempt_ms = draw_attempt_ms(&pool[tedax_id], m);
     pool[tedax_id].busy = 1;
-    pthread_cond_signal(&pool[tedax_id].cond);
-    pthread_mutex_unlock(&pool[tedax_id].lock);
+    atomic_fetch_add(&busy_count, 1);
+    tedax_kick(&pool[tedax_id]);
+    UNLOCK(&pool[tedax_id].lock);
 
-    log_event("[MANUAL] M%d -> T%d B%d (manual)", m->id, tedax_id, bench_id);
+    log_record(LOG_EV_MANUAL, m->id, tedax_id, bench_id, 0);
     return 1;
 }
 
@@ -383,4 +671,12 @@ tedax_t* tedax_get(int id) {
 
 int tedax_count(void) {
     return pool_n;
+}
+
+int tedax_remaining_ms(tedax_t *t) {
+    LOCK(&t->lock);
+    long long rem = 0;
+    if (t->current) rem = t->start_ms ? t->start_ms + t->attempt_ms - sim_now_ms() : t->attempt_ms;
+    UNLOCK(&t->lock);
+    return rem > 0 ? (int)rem : 0;
 }
\ No newline at end of file
@@ -4,34 +4,62 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include <pthread.h>
-#include <semaphore.h>
 #include "mural.h"
+#include "rng.h"
 
-// Estrutura do TEDAX (deve corresponder ao que tedax.c usa)
+// Bancadas são controladas por um bitmap atômico de 64 bits
+#define TEDAX_MAX_BENCHES 64
+
+// Estrutura do TEDAX (deve corresponder ao que tedax.c usa).
+// Um tedax é uma máquina de estados (livre -> esperando bancada ->
+// trabalhando -> livre); não tem thread própria: as transições rodam nos
+// workers do pool, acordados por timers.
 typedef struct tedax {
     int id;
     int busy;               // 0 free, 1 processing
     module_t *current;      // módulo atualmente sendo processado (propriedade durante o processamento)
     int bench_id;           // bancada atribuída (-1 se nenhuma)
-    pthread_t thr;
     pthread_mutex_t lock;
-    pthread_cond_t cond;
-    time_t start_time;
-    int remaining;
+    long long start_ms;       // início da tentativa (0 = aguardando bancada)
+    long long end_ms;         // fim planejado: duração sorteada ou prazo do módulo
+    int attempt_ms;           // duração sorteada da tentativa
+    int exploded;             // a tentativa termina com o módulo explodindo
+    long long idle_mark_ms;   // relógio de espera do mural no início da ociosidade (-1 = ocupado)
+    long long bench_wait_ns;  // entrou na fila de bancada (métrica de espera)
+    rng_t rng;                // sorteios deste tedax (duração, sucesso da IA)
 } tedax_t;
 
 // lifecycle
-void tedax_pool_init(int n, int benches_count, sem_t *benches_sem);
+void tedax_set_workers(int n);      // threads do pool no próximo init (0 = uma por núcleo)
+int tedax_worker_count(void);
+void tedax_pool_init(int n, int benches_count);
 void tedax_pool_shutdown(void);
-void tedax_pool_destroy(void);
+void tedax_pool_destroy(void);     // os workers estacionam até o próximo init
+void tedax_pool_exit(void);        // fim do programa: encerra os workers
 
 // APIs usadas por coordinator / ui / mural
 int tedax_assign_module(int id, module_t *m); // assign to specific tedax id
 int tedax_request_auto(module_t *m);           // coordinator : auto-assign -> returns tedax id or -1
+
+// Despacho em lote: reserva pares (tedax ocioso, bancada livre), retorna
+// quantos. Cada par reservado termina em start_reserved ou cancel_reserved.
+int tedax_reserve_idle(int *tedax_ids, int *bench_ids, int max);
+void tedax_start_reserved(int tedax_id, int bench_id, module_t *m);
+void tedax_cancel_reserved(int tedax_id, int bench_id);
 int tedax_request_manual(module_t *m, int tedax_id, int bench_id, int presses); // manual assign (returns 1 ok / 0 fail)
 
 tedax_t* tedax_get(int id);
 int tedax_count(void);
+int tedax_remaining_ms(tedax_t *t);  // contagem da tentativa (exibição); 0 se livre
 int tedax_bench_count(void);
+int tedax_bench_is_busy(int bench_id);
+int tedax_busy_count(void);          // tedax ocupados (sem lock)
+int tedax_benches_busy(void);        // bancadas ocupadas (sem lock)
+unsigned long tedax_version(void);   // muda a cada alteração visível de tedax/bancadas
+int tedax_explosion_count(void);     // explosões na mão desde tedax_pool_init
+long long tedax_idle_ms(void);       // soma do tempo ocioso com módulo no mural, entre os tedax (tedax-ms)
+
+// modo simulação: conclui a tentativa agendada (evento SIM_EV_TEDAX_DONE)
+void tedax_sim_complete(int id);
 
 #endif // TEDAX_H
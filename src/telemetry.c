@@ -0,0 +1,397 @@
+#define _POSIX_C_SOURCE 200809L
+#include "telemetry.h"
+#include "config.h"
+#include "mural.h"
+#include "tedax.h"
+#include "sim.h"
+#include "lockprof.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if (TELEMETRY_QUEUE & (TELEMETRY_QUEUE - 1)) != 0
+#error "TELEMETRY_QUEUE deve ser potencia de 2"
+#endif
+
+#define TEL_OUT_BYTES (256 * 1024)      // buffer de saída: um fwrite por lote
+#define TEL_LINE_MAX 512                // folga por linha antes de esvaziar o buffer
+
+typedef enum { TEL_LOG = 0, TEL_SAMPLE, TEL_ROUND, TEL_ROUND_END } tel_kind_t;
+
+typedef struct {
+    int mural, tedax_busy, tedax, benches_busy, benches, score, money;
+    long long remaining_ms;
+    int bombs;              // > 1: estado de cada bomba na amostra
+    struct { int state, score, mural; long long remaining_ms; } bomb[MURAL_MAX_BOMBS];
+} tel_sample_t;
+
+typedef struct {
+    int kind;
+    long long ts_ms;
+    union {
+        log_record_t log;
+        tel_sample_t sample;
+        struct { int round, difficulty, score, won; unsigned int seed; char policy[8]; } round;
+    } u;
+} tel_item_t;
+
+// =====================================================
+//  Fila MPSC sem lock (mesmo anel de Vyukov do coordenador)
+// =====================================================
+typedef struct {
+    atomic_size_t seq;
+    tel_item_t item;
+} tel_cell_t;
+
+static tel_cell_t *ring = NULL;
+static atomic_size_t enq_pos;
+static atomic_size_t deq_pos;              // só a escritora avança; produtores leem
+static atomic_ulong dropped;
+static atomic_int active;
+
+// a escritora dorme com prazo; produtores só a acordam com a fila pela metade
+static pthread_mutex_t tel_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tel_cond;
+static atomic_int writer_sleeping;
+static int writer_stop = 0;
+static pthread_t writer_thread;
+
+static FILE *out = NULL;
+static char *out_buf = NULL;
+static size_t out_len = 0;
+
+// amostragem (jogo com threads: pela escritora; --sim: por telemetry_tick)
+static int sample_ms = 1000;
+static int round_active = 0;               // sob tel_mutex
+static long long next_sample_ms = 0;       // sob tel_mutex no jogo; só o laço no --sim
+static atomic_int round_no;
+
+static long long mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void kick_writer(void) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&writer_sleeping, memory_order_relaxed)) {
+        LOCK(&tel_mutex);
+        pthread_cond_signal(&tel_cond);
+        UNLOCK(&tel_mutex);
+    }
+}
+
+static int try_push(const tel_item_t *it) {
+    tel_cell_t *cell;
+    size_t pos = atomic_load_explicit(&enq_pos, memory_order_relaxed);
+    for (;;) {
+        cell = &ring[pos & (TELEMETRY_QUEUE - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enq_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (dif < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&enq_pos, memory_order_relaxed);
+        }
+    }
+    cell->item = *it;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    // só quem cruza a metade acorda a escritora: o resto espera o lote
+    if (pos + 1 - atomic_load_explicit(&deq_pos, memory_order_relaxed) == TELEMETRY_QUEUE / 2)
+        kick_writer();
+    return 1;
+}
+
+static void push(const tel_item_t *it) {
+    if (try_push(it)) return;
+    if (!sim_is_enabled()) {
+        atomic_fetch_add(&dropped, 1);
+        return;
+    }
+    // --sim: uma thread só, sem prazos reais; vale esperar a escritora
+    do {
+        kick_writer();
+        sched_yield();
+    } while (!try_push(it));
+}
+
+// =====================================================
+//  Formatação (só a escritora)
+// =====================================================
+static void out_flush(void) {
+    if (out_len == 0) return;
+    fwrite(out_buf, 1, out_len, out);
+    fflush(out);
+    out_len = 0;
+}
+
+static void out_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void out_printf(const char *fmt, ...) {
+    if (TEL_OUT_BYTES - out_len < TEL_LINE_MAX) out_flush();
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out_buf + out_len, TEL_OUT_BYTES - out_len, fmt, ap);
+    va_end(ap);
+    if (n > 0) out_len += (size_t)n < TEL_OUT_BYTES - out_len ? (size_t)n : TEL_OUT_BYTES - out_len - 1;
+}
+
+// texto do log como string JSON (aspas, barras e controles escapados)
+static void json_string(const char *s, char *dst, size_t len) {
+    size_t j = 0;
+    for (; *s && j + 7 < len; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') { dst[j++] = '\\'; dst[j++] = (char)c; }
+        else if (c < 0x20) j += (size_t)snprintf(dst + j, len - j, "\\u%04x", c);
+        else dst[j++] = (char)c;
+    }
+    dst[j] = '\0';
+}
+
+static void write_item(const tel_item_t *it) {
+    switch (it->kind) {
+        case TEL_LOG: {
+            const log_record_t *r = &it->u.log;
+            if (r->code == LOG_EV_TEXT) {
+                char msg[LOG_TEXT_MAX * 6 + 1];
+                json_string(r->text, msg, sizeof(msg));
+                out_printf("{\"t\":%lld,\"ev\":\"text\",\"msg\":\"%s\"}\n", it->ts_ms, msg);
+                break;
+            }
+            char ids[96];
+            int n = 0;
+            if (r->module_id >= 0) n += snprintf(ids + n, sizeof(ids) - n, ",\"m\":%d", r->module_id);
+            if (r->tedax_id >= 0) n += snprintf(ids + n, sizeof(ids) - n, ",\"tedax\":%d", r->tedax_id);
+            if (r->bench_id >= 0) n += snprintf(ids + n, sizeof(ids) - n, ",\"bench\":%d", r->bench_id);
+            snprintf(ids + n, sizeof(ids) - n, ",\"arg\":%d", r->arg);
+            out_printf("{\"t\":%lld,\"ev\":\"%s\"%s}\n", it->ts_ms, log_code_name(r->code), ids);
+        } break;
+        case TEL_SAMPLE: {
+            const tel_sample_t *s = &it->u.sample;
+            out_printf("{\"t\":%lld,\"ev\":\"sample\",\"mural\":%d,\"tedax_busy\":%d,\"tedax\":%d,"
+                       "\"benches_busy\":%d,\"benches\":%d,\"score\":%d,\"money\":%d,\"remaining_ms\":%lld",
+                       it->ts_ms, s->mural, s->tedax_busy, s->tedax, s->benches_busy, s->benches,
+                       s->score, s->money, s->remaining_ms);
+            static const char *states[] = { "armed", "defused", "exploded" };
+            for (int b = 0; s->bombs > 1 && b < s->bombs; ++b)
+                out_printf("%s{\"state\":\"%s\",\"score\":%d,\"mural\":%d,\"remaining_ms\":%lld}",
+                           b == 0 ? ",\"bombs\":[" : ",", states[s->bomb[b].state],
+                           s->bomb[b].score, s->bomb[b].mural, s->bomb[b].remaining_ms);
+            out_printf("%s}\n", s->bombs > 1 ? "]" : "");
+        } break;
+        case TEL_ROUND:
+            out_printf("{\"t\":%lld,\"ev\":\"round_begin\",\"round\":%d,\"difficulty\":%d,\"policy\":\"%s\",\"seed\":%u}\n",
+                       it->ts_ms, it->u.round.round, it->u.round.difficulty, it->u.round.policy, it->u.round.seed);
+            break;
+        case TEL_ROUND_END:
+            out_printf("{\"t\":%lld,\"ev\":\"round_end\",\"round\":%d,\"score\":%d,\"won\":%d}\n",
+                       it->ts_ms, it->u.round.round, it->u.round.score, it->u.round.won);
+            break;
+        default: break;
+    }
+}
+
+// retira e formata tudo o que já foi publicado; retorna quantos
+static int drain(void) {
+    size_t pos = atomic_load_explicit(&deq_pos, memory_order_relaxed);
+    int n = 0;
+    for (;;) {
+        tel_cell_t *cell = &ring[pos & (TELEMETRY_QUEUE - 1)];
+        if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) break;
+        write_item(&cell->item);
+        atomic_store_explicit(&cell->seq, pos + TELEMETRY_QUEUE, memory_order_release);
+        atomic_store_explicit(&deq_pos, ++pos, memory_order_relaxed);
+        n++;
+    }
+    return n;
+}
+
+// ts_ms: hora de parede da linha; at_ms: o mesmo instante no relógio do jogo
+static long long left_at(long long deadline_ms, long long at_ms) {
+    return deadline_ms && deadline_ms > at_ms ? deadline_ms - at_ms : 0;
+}
+
+static void fill_sample(tel_item_t *it, long long ts_ms, long long at_ms) {
+    it->kind = TEL_SAMPLE;
+    it->ts_ms = ts_ms;
+    tel_sample_t *s = &it->u.sample;
+    s->mural = mural_count();
+    s->tedax_busy = tedax_busy_count();
+    s->tedax = tedax_count();
+    s->benches_busy = tedax_benches_busy();
+    s->benches = tedax_bench_count();
+    s->score = mural_get_score();
+    s->money = mural_get_money();
+    s->remaining_ms = left_at(mural_get_deadline_ms(), at_ms);
+    s->bombs = mural_bomb_count();
+    for (int b = 0; s->bombs > 1 && b < s->bombs; ++b) {
+        mural_bomb_stats_t st;
+        mural_bomb_stats(b, &st);
+        s->bomb[b].state = st.state;
+        s->bomb[b].score = st.score;
+        s->bomb[b].mural = st.active;
+        s->bomb[b].remaining_ms = st.state == BOMB_ARMED ? left_at(st.deadline_ms, at_ms) : 0;
+    }
+}
+
+// =====================================================
+//  Escritora
+// =====================================================
+static void* writer_fn(void *arg) {
+    (void)arg;
+    for (;;) {
+        drain();
+        LOCK(&tel_mutex);
+        // amostra do jogo com threads (no --sim elas já vêm pela fila)
+        if (round_active && !sim_is_enabled() && sim_now_ms() >= next_sample_ms) {
+            next_sample_ms += sample_ms;
+            UNLOCK(&tel_mutex);
+            tel_item_t it;
+            fill_sample(&it, sim_wall_ms(), sim_now_ms());
+            write_item(&it);
+            LOCK(&tel_mutex);
+        }
+        out_flush();
+        if (writer_stop) { UNLOCK(&tel_mutex); break; }
+        // prazo do lote sempre no monotônico real: no --sim o relógio do
+        // jogo é virtual e não anda enquanto o laço espera a escritora
+        long long wake = mono_ms() + TELEMETRY_FLUSH_MS;
+        if (round_active && !sim_is_enabled()) {
+            long long due = mono_ms() + (next_sample_ms - sim_now_ms());
+            if (due < wake) wake = due;
+        }
+        atomic_store_explicit(&writer_sleeping, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        size_t head = atomic_load(&enq_pos);
+        if (head - atomic_load(&deq_pos) < TELEMETRY_QUEUE / 2) {
+            struct timespec until;
+            sim_abs_timespec(wake, &until);
+            COND_TIMEDWAIT(&tel_cond, &tel_mutex, &until);
+        }
+        atomic_store_explicit(&writer_sleeping, 0, memory_order_relaxed);
+        UNLOCK(&tel_mutex);
+    }
+    drain();   // o que chegou até o stop
+    if (atomic_load(&dropped))
+        out_printf("{\"t\":%lld,\"ev\":\"telemetry_dropped\",\"count\":%lu}\n",
+                   sim_wall_ms(), atomic_load(&dropped));
+    out_flush();
+    return NULL;
+}
+
+// =====================================================
+//  API
+// =====================================================
+int telemetry_start(const char *path, int interval_ms) {
+    if (atomic_load(&active) || !path) return 0;
+    out = fopen(path, "w");
+    if (!out) return -1;
+    if (!ring) ring = malloc(TELEMETRY_QUEUE * sizeof(tel_cell_t));
+    out_buf = malloc(TEL_OUT_BYTES);
+    if (!ring || !out_buf) {
+        free(out_buf); out_buf = NULL;
+        fclose(out); out = NULL;
+        return -1;
+    }
+    for (size_t i = 0; i < TELEMETRY_QUEUE; ++i) atomic_init(&ring[i].seq, i);
+    atomic_store(&enq_pos, 0);
+    atomic_store(&deq_pos, 0);
+    atomic_store(&dropped, 0);
+    atomic_store(&round_no, 0);
+    out_len = 0;
+    sample_ms = interval_ms > 0 ? interval_ms : 1000;
+    static int cond_ready = 0;
+    if (!cond_ready) { sim_cond_init(&tel_cond); cond_ready = 1; } // prazos no relógio monotônico
+    writer_stop = 0;
+    round_active = 0;
+    if (pthread_create(&writer_thread, NULL, writer_fn, NULL) != 0) {
+        free(out_buf); out_buf = NULL;
+        fclose(out); out = NULL;
+        return -1;
+    }
+    atomic_store(&active, 1);
+    return 0;
+}
+
+void telemetry_stop(void) {
+    if (!atomic_load(&active)) return;
+    atomic_store(&active, 0);   // produtores atrasados passam a ignorar
+    LOCK(&tel_mutex);
+    writer_stop = 1;
+    pthread_cond_signal(&tel_cond);
+    UNLOCK(&tel_mutex);
+    pthread_join(writer_thread, NULL);
+    fclose(out);
+    out = NULL;
+    free(out_buf);
+    out_buf = NULL;
+    // o anel fica: um produtor que leu active = 1 pouco antes ainda pode escrever nele
+}
+
+int telemetry_enabled(void) { return atomic_load_explicit(&active, memory_order_relaxed); }
+unsigned long telemetry_dropped(void) { return atomic_load(&dropped); }
+
+void telemetry_log(const log_record_t *r) {
+    if (!atomic_load_explicit(&active, memory_order_relaxed)) return;
+    tel_item_t it;
+    it.kind = TEL_LOG;
+    it.ts_ms = r->ts_ms;
+    it.u.log = *r;
+    push(&it);
+}
+
+void telemetry_round_begin(int difficulty, const char *policy, unsigned int seed) {
+    if (!atomic_load(&active)) return;
+    tel_item_t it;
+    it.kind = TEL_ROUND;
+    it.ts_ms = sim_wall_ms();
+    it.u.round.round = atomic_fetch_add(&round_no, 1) + 1;
+    it.u.round.difficulty = difficulty;
+    it.u.round.seed = seed;
+    it.u.round.score = it.u.round.won = 0;
+    snprintf(it.u.round.policy, sizeof(it.u.round.policy), "%s", policy ? policy : "?");
+    push(&it);
+    LOCK(&tel_mutex);
+    round_active = 1;
+    next_sample_ms = sim_now_ms();
+    pthread_cond_signal(&tel_cond);   // 1ª amostra já no início da rodada
+    UNLOCK(&tel_mutex);
+}
+
+void telemetry_round_end(int score, int won) {
+    if (!atomic_load(&active)) return;
+    LOCK(&tel_mutex);
+    round_active = 0;
+    UNLOCK(&tel_mutex);
+    tel_item_t it;
+    it.kind = TEL_ROUND_END;
+    it.ts_ms = sim_wall_ms();
+    it.u.round.round = atomic_load(&round_no);
+    it.u.round.score = score;
+    it.u.round.won = won;
+    it.u.round.difficulty = 0;
+    it.u.round.seed = 0;
+    it.u.round.policy[0] = '\0';
+    push(&it);
+}
+
+void telemetry_tick(long long now_ms) {
+    if (!atomic_load_explicit(&active, memory_order_relaxed)) return;
+    // o estado não muda entre dois eventos: a amostra de cada instante
+    // anterior a now_ms é exatamente o estado atual
+    while (next_sample_ms < now_ms) {
+        tel_item_t it;
+        fill_sample(&it, next_sample_ms, next_sample_ms);
+        push(&it);
+        next_sample_ms += sample_ms;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "eventlog.h"
+
+// Telemetria em JSON lines (ksne --telemetry ARQ): cada registro do log,
+// início/fim de rodada e amostras periódicas do estado do jogo (mural,
+// tedax e bancadas ocupados, score, moedas, tempo restante) viram uma
+// linha JSON. Produtores só copiam o registro para uma fila MPSC em
+// memória, sem lock e sem syscall; uma thread escritora drena a fila em
+// lotes e grava em blocos grandes.
+//
+// Fila cheia: no jogo com threads o registro é descartado (e contado),
+// nunca bloqueia mural ou tedax; no modo --sim o laço de eventos espera a
+// escritora, para que a saída headless seja completa e reprodutível.
+
+int telemetry_start(const char *path, int sample_ms);   // 0 ou -1
+void telemetry_stop(void);          // drena a fila, grava e fecha o arquivo
+int telemetry_enabled(void);
+unsigned long telemetry_dropped(void);
+
+// Produtores (qualquer thread)
+void telemetry_log(const log_record_t *r);      // chamado pelo eventlog
+void telemetry_round_begin(int difficulty, const char *policy, unsigned int seed);
+void telemetry_round_end(int score, int won);
+
+// Amostras: no jogo a escritora amostra a cada sample_ms enquanto há
+// rodada; no --sim o laço de eventos chama telemetry_tick(agora) antes de
+// tratar cada evento, e as amostras saem nos instantes virtuais exatos
+void telemetry_tick(long long now_ms);
+
+#endif // TELEMETRY_H
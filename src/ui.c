@@ -4,10 +4,16 @@
 #include "tedax.h"
 #include "config.h"
 #include "coordinator.h" 
+#include "sim.h"
+#include "lockprof.h"
+#include "halt.h"
+#include "park.h"
 
 #include <ncurses.h>
 #include <pthread.h>
-#include <stdarg.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h> 
@@ -19,8 +25,18 @@
 enum { CP_DEFAULT=1, CP_TITLE, CP_HEADER, CP_OK, CP_WARN, CP_ERR, CP_ACCENT, CP_SELECT };
 
 static pthread_t ui_thread;
+static park_t ui_park = PARK_INITIALIZER;   // a thread estaciona entre rodadas
 static volatile int ui_running = 0;
 
+// Uma sessão ncurses para o processo todo (menus e jogo): aberta no
+// primeiro uso e fechada só em ui_exit. Menus e thread da UI nunca
+// desenham ao mesmo tempo: a thread está estacionada enquanto há menu.
+static int screen_ready = 0;
+
+// Acordar a UI: outras threads escrevem 1 byte no pipe quando ela dorme
+static int wake_pipe[2] = { -1, -1 };
+static atomic_int ui_waiting;
+
 // Estados da Interface In-Game
 enum { 
     MODE_NORMAL=0, 
@@ -30,6 +46,14 @@ enum {
     MODE_INPUT_CMD 
 };
 
+// Fim de rodada: ui_linger deixa o tabuleiro congelado na tela até o
+// prazo ou até uma tecla (a thread da UI encerra a espera)
+static pthread_mutex_t linger_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t linger_cond;
+static pthread_once_t linger_once = PTHREAD_ONCE_INIT;
+static atomic_int lingering;
+static int linger_ms = UI_LINGER_MS;
+
 static int ui_mode = MODE_NORMAL;
 static int sel_idx = 0;
 static int selected_mod_id = -1;
@@ -42,40 +66,48 @@ static int input_pos = 0;
 // Windows (Adicionada w_completed)
 static WINDOW *w_header, *w_mural, *w_completed, *w_tedax, *w_bench, *w_log, *w_cmd;
 
-// Log buffer
-static char *logbuf[LOG_LINES];
-static int log_pos = -1;
-static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
-
 // --- FUNÇÕES DE ESTADO ---
 int is_ui_active(void) { return ui_running; }
 
+static void screen_open(void) {
+    if (screen_ready) return;
+    initscr(); start_color(); use_default_colors();
+    init_pair(CP_DEFAULT, COLOR_WHITE, -1);
+    init_pair(CP_TITLE, COLOR_CYAN, -1);
+    init_pair(CP_HEADER, COLOR_YELLOW, -1);
+    init_pair(CP_OK, COLOR_GREEN, -1);
+    init_pair(CP_WARN, COLOR_YELLOW, -1);
+    init_pair(CP_ERR, COLOR_RED, -1);
+    init_pair(CP_ACCENT, COLOR_MAGENTA, -1);
+    init_pair(CP_SELECT, COLOR_BLACK, COLOR_CYAN);
+    noecho(); cbreak(); curs_set(0); keypad(stdscr, TRUE);
+    screen_ready = 1;
+}
+
 // --- MENUS ---
 void show_start_screen(void) {
-    initscr(); start_color(); noecho(); curs_set(0); keypad(stdscr, TRUE);
-    init_pair(1, COLOR_WHITE, COLOR_BLACK);
-    init_pair(2, COLOR_CYAN, COLOR_BLACK);
+    screen_open();
     const char *title = "KEEP SOLVING!!";
     const char *press = "Pressione qualquer tecla";
     const char *footer = "© 2025 IDP - Keep Solving and Nobody Explodes";
-    int blink = 0; nodelay(stdscr, TRUE);
+    // getch espera no máximo 50 ms: o pisca anda e a tecla volta na hora
+    int blink = 0; timeout(50);
     while (1) {
         clear(); int h, w; getmaxyx(stdscr, h, w);
-        attron(A_BOLD | COLOR_PAIR(2));
+        attron(A_BOLD | COLOR_PAIR(CP_TITLE));
         mvprintw(h/2-2, (w-(int)strlen(title))/2, "%s", title);
-        attroff(A_BOLD | COLOR_PAIR(2));
+        attroff(A_BOLD | COLOR_PAIR(CP_TITLE));
         if (blink < 10) mvprintw(h/2, (w-(int)strlen(press))/2, "%s", press);
         mvprintw(h-2, (w-(int)strlen(footer))/2, "%s", footer);
         refresh();
         if (getch() != ERR) break;
-        struct timespec ts = {0, 50000000}; nanosleep(&ts, NULL);
         blink = (blink + 1) % 20;
     }
-    nodelay(stdscr, FALSE); endwin();
+    timeout(-1);
 }
 
 int show_main_menu_ncurses(void) {
-    initscr(); start_color(); noecho(); curs_set(0); keypad(stdscr, TRUE);
+    screen_open(); nodelay(stdscr, FALSE);
     const char *options[] = {"Modo Classico", "Opcoes (N/A)", "Sair"};
     int n=3, sel=0;
     while(1) {
@@ -91,12 +123,12 @@ int show_main_menu_ncurses(void) {
         int ch = getch();
         if(ch==KEY_UP) { sel--; if(sel<0) sel=n-1; }
         else if(ch==KEY_DOWN) { sel++; if(sel>=n) sel=0; }
-        else if(ch==10) { endwin(); return sel; }
+        else if(ch==10) return sel;
     }
 }
 
 int show_difficulty_menu_ncurses(void) {
-    initscr(); start_color(); noecho(); curs_set(0); keypad(stdscr, TRUE);
+    screen_open(); nodelay(stdscr, FALSE);
     const char *options[] = {"[1] Facil", "[2] Medio", "[3] Dificil", "[4] Insano"};
     int n=4, sel=1;
     while(1) {
@@ -111,25 +143,10 @@ int show_difficulty_menu_ncurses(void) {
         int ch = getch();
         if(ch==KEY_UP) { sel--; if(sel<0) sel=n-1; }
         else if(ch==KEY_DOWN) { sel++; if(sel>=n) sel=0; }
-        else if(ch==10) { endwin(); return sel+1; }
+        else if(ch==10) return sel+1;
     }
 }
 
-// --- LOGGING ---
-void log_event(const char *fmt, ...) {
-    va_list ap; va_start(ap, fmt);
-    char tmp[256]; vsnprintf(tmp, sizeof(tmp), fmt, ap); va_end(ap);
-    pthread_mutex_lock(&log_lock);
-    log_pos = (log_pos + 1) % LOG_LINES;
-    if (logbuf[log_pos]) free(logbuf[log_pos]);
-    char *entry = malloc(320);
-    time_t t = time(NULL);
-    struct tm tm = *localtime(&t);
-    snprintf(entry, 320, "[%02d:%02d:%02d] %s", tm.tm_hour, tm.tm_min, tm.tm_sec, tmp);
-    logbuf[log_pos] = entry;
-    pthread_mutex_unlock(&log_lock);
-}
-
 // --- UI DRAWING ---
 static void draw_border_title(WINDOW *w, const char *title) {
     werase(w); box(w, 0, 0);
@@ -142,27 +159,40 @@ static void seconds_to_mmss(int s, char *buf, int len) {
     int m=s/60; int sec=s%60; snprintf(buf, len, "%02d:%02d", m, sec);
 }
 
-static void draw_header(int cols) {
+static const char* type_name(module_type_t t) {
+    return t==MOD_FIOS?"FIOS":(t==MOD_BOTAO?"BOTAO":"SENHA");
+}
+
+static void draw_header(int cols, const mural_snapshot_t *snap) {
     (void)cols; werase(w_header);
     wattron(w_header, A_BOLD | COLOR_PAIR(CP_HEADER));
-    int rem = mural_get_remaining_seconds();
+    int rem = 0;
+    if (snap->deadline_ms != 0) { rem = (int)((snap->deadline_ms - sim_now_ms() + 999) / 1000); if (rem < 0) rem = 0; }
     char tbuf[16]; seconds_to_mmss(rem, tbuf, sizeof(tbuf));
     mvwprintw(w_header, 0, 1, " Keep Solving - BOMB PANEL | SCORE: %d | GOLD: %d | TIME: %s ", 
-              mural_get_score(), mural_get_money(), tbuf);
-    wattroff(w_header, A_BOLD | COLOR_PAIR(CP_HEADER)); wrefresh(w_header);
+              snap->score, snap->money, tbuf);
+    // multi-bomba: placar e timer de cada uma, na sequência
+    for (int b = 0; snap->bombs > 1 && b < snap->bombs; ++b) {
+        const mural_bomb_stats_t *st = &snap->bomb[b];
+        if (st->state == BOMB_DEFUSED) wprintw(w_header, "| B%d OK ", b + 1);
+        else if (st->state == BOMB_EXPLODED) wprintw(w_header, "| B%d BOOM ", b + 1);
+        else {
+            int brem = (int)((st->deadline_ms - sim_now_ms() + 999) / 1000);
+            seconds_to_mmss(brem < 0 ? 0 : brem, tbuf, sizeof(tbuf));
+            wprintw(w_header, "| B%d %d/%d %s ", b + 1, st->score, WIN_SCORE_TARGET, tbuf);
+        }
+    }
+    wattroff(w_header, A_BOLD | COLOR_PAIR(CP_HEADER)); wnoutrefresh(w_header);
 }
 
-static void draw_mural_panel() {
+static void draw_mural_panel(const mural_snapshot_t *snap) {
     draw_border_title(w_mural, " ATIVOS ");
     int row = 1;
-    mural_lock_access();
-    module_t *cur = mural_peek_list();
-    time_t now = time(NULL);
+    long long now = sim_now_ms();
     int maxr = getmaxy(w_mural)-2;
-    int idx = 0;
-    while (cur && row <= maxr) {
-        int age = (int)(now - cur->created_at);
-        int rem = cur->timeout_secs - age;
+    for (int idx = 0; idx < snap->active_n && row <= maxr; ++idx, ++row) {
+        const module_view_t *v = &snap->active[idx];
+        int rem = (int)((v->deadline_ms - now) / 1000);
         if (ui_mode == MODE_SEL_MOD && idx == sel_idx) {
             wattron(w_mural, A_REVERSE | A_BOLD); mvwprintw(w_mural, row, 1, "->");
         } else mvwprintw(w_mural, row, 1, "  ");
@@ -177,52 +207,55 @@ static void draw_mural_panel() {
         if(filled > barlen) { filled = barlen; }
         char bar[32]; int p=0; for(int k=0;k<barlen;k++) bar[p++]=(k<filled?'#':'.'); bar[p]=0;
         
-        mvwprintw(w_mural, row, 4, "M%-2d|%-6s|%s|%2ds",
-              cur->id, (cur->type==MOD_FIOS?"FIOS":(cur->type==MOD_BOTAO?"BOTAO":"SENHA")), bar, cur->time_required);
+        if (snap->bombs > 1)
+            mvwprintw(w_mural, row, 4, "M%-2d|B%d|%-6s|%s|%2ds",
+                      v->id, v->bomb + 1, type_name(v->type), bar, v->time_required);
+        else
+            mvwprintw(w_mural, row, 4, "M%-2d|%-6s|%s|%2ds",
+                      v->id, type_name(v->type), bar, v->time_required);
         wattroff(w_mural, A_BLINK|COLOR_PAIR(CP_ERR)|COLOR_PAIR(CP_WARN)|COLOR_PAIR(CP_OK));
         if (ui_mode == MODE_SEL_MOD && idx == sel_idx) wattroff(w_mural, A_REVERSE | A_BOLD);
-        cur=cur->next; row++; idx++;
     }
-    mural_unlock_access(); wrefresh(w_mural);
+    wnoutrefresh(w_mural);
 }
 
 // --- NOVO: PAINEL DE RESOLVIDOS ---
-static void draw_completed_panel() {
-    draw_border_title(w_completed, " RESOLVIDOS ");
-    int row = 1;
-    mural_lock_access();
-    module_t *cur = mural_peek_resolved();
+static void draw_completed_panel(const mural_snapshot_t *snap) {
+    char title[32];
+    snprintf(title, sizeof(title), " RESOLVIDOS (%d) ", snap->resolved_total);
+    draw_border_title(w_completed, title);
     int maxr = getmaxy(w_completed)-2;
-    
-    while (cur && row <= maxr) {
+    for (int i = 0; i < snap->resolved_n && i < maxr; ++i) {
         wattron(w_completed, COLOR_PAIR(CP_OK));
-        mvwprintw(w_completed, row, 2, "M%-2d [OK] %s", 
-                  cur->id, 
-                  (cur->type==MOD_FIOS?"FIOS":(cur->type==MOD_BOTAO?"BOTAO":"SENHA")));
+        mvwprintw(w_completed, i + 1, 2, "M%-2d [OK] %s", 
+                  snap->resolved[i].id, type_name(snap->resolved[i].type));
         wattroff(w_completed, COLOR_PAIR(CP_OK));
-        cur = cur->next;
-        row++;
     }
-    mural_unlock_access(); 
-    wrefresh(w_completed);
+    wnoutrefresh(w_completed);
 }
 
 static void draw_tedax_panel() {
     draw_border_title(w_tedax, " TEDAX ");
     int row = 1; int n = tedax_count();
-    for (int i=0;i<n;i++) {
+    int maxr = getmaxy(w_tedax)-2;
+    // tripulações grandes: a janela acompanha a seleção
+    int first = (ui_mode == MODE_SEL_TEDAX && sel_idx >= maxr) ? sel_idx - maxr + 1 : 0;
+    for (int i=first;i<n && row<=maxr;i++) {
         tedax_t *t = tedax_get(i);
         int is_sel = (ui_mode == MODE_SEL_TEDAX && i == sel_idx);
         if (is_sel) wattron(w_tedax, A_REVERSE | A_BOLD);
-        pthread_mutex_lock(&t->lock);
-        if (t->current) {
+        LOCK(&t->lock);
+        int working = t->current != NULL;
+        module_type_t type = working ? t->current->type : MOD_FIOS;
+        UNLOCK(&t->lock);
+        if (working) {
             wattron(w_tedax, COLOR_PAIR(CP_ACCENT));
             {
-                int rem = t->remaining;
-                if (rem < 0) rem = 0;
+                // contagem da tentativa sorteada (a explosão não é anunciada)
+                int rem = (tedax_remaining_ms(t) + 999) / 1000;
                 char tbuf[16]; seconds_to_mmss(rem, tbuf, sizeof(tbuf));
                 mvwprintw(w_tedax, row++, 1, "%sT%d: [O] %s | %s", is_sel?"->":"  ", t->id,
-                          (t->current->type==MOD_FIOS?"FIOS":(t->current->type==MOD_BOTAO?"BOTAO":"SENHA")), tbuf);
+                          type_name(type), tbuf);
             }
             wattroff(w_tedax, COLOR_PAIR(CP_ACCENT));
         } else {
@@ -230,24 +263,16 @@ static void draw_tedax_panel() {
             mvwprintw(w_tedax, row++, 1, "%sT%d: [ ] LIVRE", is_sel?"->":"  ", t->id);
             wattroff(w_tedax, COLOR_PAIR(CP_OK));
         }
-        pthread_mutex_unlock(&t->lock);
         if (is_sel) wattroff(w_tedax, A_REVERSE | A_BOLD);
     }
-    wrefresh(w_tedax);
+    wnoutrefresh(w_tedax);
 }
 
 static void draw_bench_panel() {
     draw_border_title(w_bench, " BANCADAS ");
-    int n_tedax = tedax_count();
     int nb = tedax_bench_count();
     for (int i=0; i<nb; i++) {
-        int is_busy = 0;
-        for(int t=0; t<n_tedax; t++) {
-            tedax_t *td = tedax_get(t);
-            pthread_mutex_lock(&td->lock);
-            if(td->busy && td->bench_id == i) is_busy = 1;
-            pthread_mutex_unlock(&td->lock);
-        }
+        int is_busy = tedax_bench_is_busy(i);
         int is_sel = (ui_mode == MODE_SEL_BENCH && i == sel_idx);
         if (is_sel) wattron(w_bench, A_REVERSE);
         if (is_busy) {
@@ -261,32 +286,36 @@ static void draw_bench_panel() {
         }
         if (is_sel) wattroff(w_bench, A_REVERSE);
     }
-    wrefresh(w_bench);
+    wnoutrefresh(w_bench);
 }
 
 static void draw_log_panel() {
     draw_border_title(w_log, " LOG ");
-    pthread_mutex_lock(&log_lock);
-    int maxr = getmaxy(w_log)-2; int row = 1; int idx = log_pos;
-    for (int i=0;i<maxr;i++) {
-        if (idx < 0) break;
-        char *e = logbuf[idx];
-        if (e) {
-            if (strstr(e,"EXPLODIU")||strstr(e,"FALHOU")||strstr(e,"timeout")) wattron(w_log, COLOR_PAIR(CP_ERR));
-            else if (strstr(e,"DESARMADO")||strstr(e,"sucesso")) wattron(w_log, COLOR_PAIR(CP_OK));
-            else if (strstr(e,"Auto")||strstr(e,"ASSIGN")) wattron(w_log, COLOR_PAIR(CP_ACCENT));
-            mvwprintw(w_log, row++, 1, "%s", e);
-            wattroff(w_log, COLOR_PAIR(CP_ERR)|COLOR_PAIR(CP_OK)|COLOR_PAIR(CP_ACCENT));
-        }
-        idx = (idx-1+LOG_LINES)%LOG_LINES;
+    // formatação só acontece aqui, no consumidor
+    log_record_t recs[LOG_LINES];
+    int maxr = getmaxy(w_log)-2; int row = 1;
+    if (maxr > LOG_LINES) maxr = LOG_LINES;
+    int n = log_read_recent(recs, maxr);
+    char line[LOG_TEXT_MAX + 64];
+    for (int i=0;i<n;i++) {
+        log_format(&recs[i], line, sizeof(line));
+        int cp = recs[i].severity == LOG_SEV_ERR ? CP_ERR
+               : recs[i].severity == LOG_SEV_OK ? CP_OK
+               : recs[i].severity == LOG_SEV_ACCENT ? CP_ACCENT : 0;
+        if (cp) wattron(w_log, COLOR_PAIR(cp));
+        mvwprintw(w_log, row++, 1, "%s", line);
+        if (cp) wattroff(w_log, COLOR_PAIR(cp));
     }
-    pthread_mutex_unlock(&log_lock); wrefresh(w_log);
+    wnoutrefresh(w_log);
 }
 
 static void draw_cmd_panel() {
     draw_border_title(w_cmd, " COMANDOS ");
-    if (ui_mode==MODE_NORMAL) {
-        mvwprintw(w_cmd, 1, 2, "[A] Auto | [D] Selecionar | [Q] Menu Principal");
+    if (atomic_load(&lingering)) {
+        mvwprintw(w_cmd, 1, 2, "FIM DA RODADA | Qualquer tecla volta ao Menu Principal");
+    } else if (ui_mode==MODE_NORMAL) {
+        mvwprintw(w_cmd, 1, 2, "[A] Auto | [D] Selecionar | [P] Piloto: %s | [Q] Menu Principal",
+                  coord_autopilot() ? "ON" : "OFF");
     } else if (ui_mode==MODE_SEL_MOD) {
         mvwprintw(w_cmd, 1, 2, "SELECIONE MODULO | [Q] Cancelar");
     } else if (ui_mode==MODE_SEL_TEDAX) {
@@ -296,23 +325,170 @@ static void draw_cmd_panel() {
     } else if (ui_mode==MODE_INPUT_CMD) {
         mvwprintw(w_cmd, 1, 2, "Instrucao: %s_", input_buf);
     }
-    wrefresh(w_cmd);
+    wnoutrefresh(w_cmd);
 }
 
-static void* ui_thread_fn(void *arg) {
-    (void)arg;
-    initscr(); start_color(); use_default_colors();
-    init_pair(CP_DEFAULT, COLOR_WHITE, -1);
-    init_pair(CP_TITLE, COLOR_CYAN, -1);
-    init_pair(CP_HEADER, COLOR_YELLOW, -1);
-    init_pair(CP_OK, COLOR_GREEN, -1);
-    init_pair(CP_WARN, COLOR_YELLOW, -1);
-    init_pair(CP_ERR, COLOR_RED, -1);
-    init_pair(CP_ACCENT, COLOR_MAGENTA, -1);
-    init_pair(CP_SELECT, COLOR_BLACK, COLOR_CYAN);
-    noecho(); cbreak(); curs_set(0); keypad(stdscr, TRUE); nodelay(stdscr, TRUE);
+// Trata uma tecla; toda tecla conta como mudança de estado da UI
+static void linger_end(void) {
+    LOCK(&linger_mutex);
+    atomic_store(&lingering, 0);
+    pthread_cond_signal(&linger_cond);
+    UNLOCK(&linger_mutex);
+}
 
+static void handle_key(int ch) {
+    if (atomic_load(&lingering)) { linger_end(); return; }
+    if (ui_mode == MODE_INPUT_CMD) {
+        if (ch != ERR) {
+            if (ch == '\n' || ch == KEY_ENTER || ch == 10 || ch == 13) {
+                char cmd[128]; 
+                snprintf(cmd, 128, "M %d %d %d %s", selected_mod_id, selected_tedax_id, selected_bench_id, input_buf);
+                if (coord_enqueue_command(cmd) != COORD_OK) log_event("[UI] Fila de comandos cheia: comando descartado");
+                ui_mode = MODE_NORMAL;
+                input_pos = 0; input_buf[0] = '\0';
+            }
+            else if (ch == KEY_BACKSPACE || ch == 127 || ch == '\b') {
+                if (input_pos > 0) {
+                    input_buf[--input_pos] = '\0';
+                }
+            }
+            else if (ch == 27) { 
+                ui_mode = MODE_NORMAL;
+                input_pos = 0; input_buf[0] = '\0';
+            }
+            else if (isprint(ch) && input_pos < 60) {
+                input_buf[input_pos++] = (char)ch;
+                input_buf[input_pos] = '\0';
+            }
+        }
+    }
+    else if (ui_mode == MODE_NORMAL) {
+        if (ch == 'q' || ch == 'Q') { ui_running = 0; halt_raise(HALT_QUIT); return; }
+        else if (ch == 'a' || ch == 'A') {
+            if (coord_enqueue_command("A") == COORD_OK) log_record(LOG_EV_UI_AUTO, -1, -1, -1, 0);
+            else log_event("[UI] Fila de comandos cheia: auto-assign descartado");
+        }
+        else if (ch == 'p' || ch == 'P') {
+            coord_set_autopilot(!coord_autopilot());
+            log_event("[UI] Piloto automatico %s", coord_autopilot() ? "ligado" : "desligado");
+        }
+        else if (ch == 'd' || ch == 'D') { 
+            const mural_snapshot_t *snap = mural_snapshot_acquire();
+            int cnt = snap->active_n;
+            mural_snapshot_release(snap);
+            if (cnt>0) { ui_mode=MODE_SEL_MOD; sel_idx=0; } else log_event("[UI] Mural vazio!");
+        }
+    }
+    else if (ui_mode == MODE_SEL_MOD) {
+        // a seleção segue o que está desenhado: mesmo snapshot do painel
+        const mural_snapshot_t *snap = mural_snapshot_acquire();
+        int cnt = snap->active_n;
+        if(cnt==0) { ui_mode=MODE_NORMAL; }
+        else if (ch==KEY_UP) sel_idx=(sel_idx-1+cnt)%cnt;
+        else if (ch==KEY_DOWN) sel_idx=(sel_idx+1)%cnt;
+        else if (ch=='q'||ch=='Q'||ch==27) ui_mode=MODE_NORMAL;
+        else if (ch==10 || ch==KEY_ENTER || ch==13) {
+             if (sel_idx < cnt) selected_mod_id = snap->active[sel_idx].id;
+             ui_mode=MODE_SEL_TEDAX; sel_idx=0;
+        }
+        mural_snapshot_release(snap);
+    }
+    else if (ui_mode == MODE_SEL_TEDAX) {
+         int cnt=tedax_count();
+         if (ch==KEY_UP) sel_idx=(sel_idx-1+cnt)%cnt;
+         else if (ch==KEY_DOWN) sel_idx=(sel_idx+1)%cnt;
+         else if (ch==10 || ch==KEY_ENTER || ch==13) { selected_tedax_id=sel_idx; ui_mode=MODE_SEL_BENCH; sel_idx=0; }
+    }
+    else if (ui_mode == MODE_SEL_BENCH) {
+         int cnt=tedax_bench_count();
+         if (ch==KEY_UP) sel_idx=(sel_idx-1+cnt)%cnt;
+         else if (ch==KEY_DOWN) sel_idx=(sel_idx+1)%cnt;
+         else if (ch==10 || ch==KEY_ENTER || ch==13) {
+             selected_bench_id=sel_idx;
+             ui_mode = MODE_INPUT_CMD;
+             input_pos = 0; input_buf[0] = '\0';
+         }
+    }
+}
+
+// =====================================================
+//  Render orientado a mudanças
+// =====================================================
+// Cada painel guarda a versão do estado que desenhou da última vez e só é
+// redesenhado quando ela muda (ou quando o relógio vira o segundo, para o
+// timer e as cores de urgência). Os painéis sujos vão juntos num doupdate.
+static unsigned long ui_state_ver = 1;   // modo/seleção/input (só a thread da UI)
+
+static struct {
+    long long sec;
+    unsigned long mural, tedax, log, ui;
+    int linger;
+} drawn;
+
+static int render_dirty(int force) {
+    long long sec = sim_now_ms() / 1000;
+    const mural_snapshot_t *snap = mural_snapshot_acquire();
+    unsigned long mv = snap->version, tv = tedax_version(), lv = log_version();
+    int tick = force || sec != drawn.sec;
+    int mural_dirty = force || mv != drawn.mural;
+    int tedax_dirty = force || tv != drawn.tedax;
+    int linger = atomic_load(&lingering);
+    int ui_dirty = force || ui_state_ver != drawn.ui || linger != drawn.linger;
+    int n = 0;
+
+    if (tick || mural_dirty)             { draw_header(COLS, snap); n++; }
+    if (tick || mural_dirty || ui_dirty) { draw_mural_panel(snap); n++; }
+    if (mural_dirty)                     { draw_completed_panel(snap); n++; }
+    if (tick || tedax_dirty || ui_dirty) { draw_tedax_panel(); draw_bench_panel(); n += 2; }
+    if (force || lv != drawn.log)        { draw_log_panel(); n++; }
+    if (ui_dirty)                        { draw_cmd_panel(); n++; }
+    mural_snapshot_release(snap);
+    if (n) doupdate();
+
+    drawn.sec = sec; drawn.mural = mv; drawn.tedax = tv; drawn.log = lv; drawn.ui = ui_state_ver;
+    drawn.linger = linger;
+    return n;
+}
+
+static int state_changed(void) {
+    return mural_version() != drawn.mural || tedax_version() != drawn.tedax
+        || log_version() != drawn.log || sim_now_ms() / 1000 != drawn.sec
+        || atomic_load(&lingering) != drawn.linger;
+}
+
+// Dorme até: tecla, ui_wake() de outra thread, ou a virada do segundo
+static void wait_for_change(void) {
+    atomic_store(&ui_waiting, 1);
+    // releitura depois de anunciar a espera: quem mudou algo antes disso
+    // já está refletido nas versões, quem mudar depois escreve no pipe
+    if (ui_running && !state_changed()) {
+        int timeout_ms = 1000 - (int)(sim_now_ms() % 1000);
+        struct pollfd fds[2] = {
+            { .fd = STDIN_FILENO, .events = POLLIN },
+            { .fd = wake_pipe[0], .events = POLLIN },
+        };
+        poll(fds, 2, timeout_ms);
+    }
+    atomic_store(&ui_waiting, 0);
+    char drain[64];
+    while (read(wake_pipe[0], drain, sizeof(drain)) > 0) { }
+}
+
+// Janelas do jogo: criadas na primeira rodada e refeitas só se o
+// terminal mudou de tamanho desde então
+static int win_h = 0, win_w = 0;
+
+static void delete_windows(void) {
+    if (!w_header) return;
+    delwin(w_header); delwin(w_mural); delwin(w_completed); 
+    delwin(w_tedax); delwin(w_bench); delwin(w_log); delwin(w_cmd);
+    w_header = NULL;
+}
+
+static void ensure_windows(void) {
     int H = LINES, W = COLS;
+    if (w_header && H == win_h && W == win_w) return;
+    delete_windows();
     // Layout novo: Metade esquerda p/ mural, metade direita p/ resolvidos
     w_header = newwin(1, W, 0, 0);
     w_mural  = newwin(H/2 - 1, W/2, 1, 0);
@@ -323,101 +499,87 @@ static void* ui_thread_fn(void *arg) {
     w_cmd    = newwin(3, W, H - 3, 0);
     
     keypad(w_cmd, TRUE);
+    win_h = H; win_w = W;
+}
 
-    ui_running = 1;
+static void ui_round(void) {
+    nodelay(stdscr, TRUE);
+    ensure_windows();
+
+    // stdscr limpo uma vez por rodada (apaga o menu): o getch() não volta
+    // a apagar os painéis
+    clear(); refresh();
+
+    render_dirty(1);
     while (ui_running) {
-        // Agora desenhamos também o painel de resolvidos
-        draw_header(W); draw_mural_panel(); draw_completed_panel();
-        draw_tedax_panel(); draw_bench_panel(); draw_log_panel(); draw_cmd_panel();
-        
-        int ch = getch();
-        
-        if (ui_mode == MODE_INPUT_CMD) {
-            if (ch != ERR) {
-                if (ch == '\n' || ch == KEY_ENTER || ch == 10 || ch == 13) {
-                    char cmd[128]; 
-                    snprintf(cmd, 128, "M %d %d %d %s", selected_mod_id, selected_tedax_id, selected_bench_id, input_buf);
-                    coord_enqueue_command(cmd); 
-                    ui_mode = MODE_NORMAL;
-                    input_pos = 0; input_buf[0] = '\0';
-                }
-                else if (ch == KEY_BACKSPACE || ch == 127 || ch == '\b') {
-                    if (input_pos > 0) {
-                        input_buf[--input_pos] = '\0';
-                    }
-                }
-                else if (ch == 27) { 
-                    ui_mode = MODE_NORMAL;
-                    input_pos = 0; input_buf[0] = '\0';
-                }
-                else if (isprint(ch) && input_pos < 60) {
-                    input_buf[input_pos++] = (char)ch;
-                    input_buf[input_pos] = '\0';
-                }
-            }
-        }
-        else if (ui_mode == MODE_NORMAL) {
-            if (ch == 'q' || ch == 'Q') { ui_running = 0; break; }
-            else if (ch == 'a' || ch == 'A') { coord_enqueue_command("A"); log_event("[UI] Auto-assign"); }
-            else if (ch == 'd' || ch == 'D') { 
-                if (mural_count()>0) { ui_mode=MODE_SEL_MOD; sel_idx=0; } else log_event("[UI] Mural vazio!");
-            }
-        }
-        else if (ui_mode == MODE_SEL_MOD) {
-            int cnt = mural_count(); if(cnt==0) { ui_mode=MODE_NORMAL; continue; }
-            if (ch==KEY_UP) sel_idx=(sel_idx-1+cnt)%cnt;
-            else if (ch==KEY_DOWN) sel_idx=(sel_idx+1)%cnt;
-            else if (ch=='q'||ch=='Q'||ch==27) ui_mode=MODE_NORMAL;
-            else if (ch==10 || ch==KEY_ENTER || ch==13) {
-                 module_t *m = mural_get_by_index(sel_idx); 
-                 if(m) selected_mod_id = m->id;
-                 ui_mode=MODE_SEL_TEDAX; sel_idx=0;
-            }
-        }
-        else if (ui_mode == MODE_SEL_TEDAX) {
-             int cnt=tedax_count();
-             if (ch==KEY_UP) sel_idx=(sel_idx-1+cnt)%cnt;
-             else if (ch==KEY_DOWN) sel_idx=(sel_idx+1)%cnt;
-             else if (ch==10 || ch==KEY_ENTER || ch==13) { selected_tedax_id=sel_idx; ui_mode=MODE_SEL_BENCH; sel_idx=0; }
-        }
-        else if (ui_mode == MODE_SEL_BENCH) {
-             int cnt=NUM_BENCHES;
-             if (ch==KEY_UP) sel_idx=(sel_idx-1+cnt)%cnt;
-             else if (ch==KEY_DOWN) sel_idx=(sel_idx+1)%cnt;
-             else if (ch==10 || ch==KEY_ENTER || ch==13) {
-                 selected_bench_id=sel_idx;
-                 ui_mode = MODE_INPUT_CMD;
-                 input_pos = 0; input_buf[0] = '\0';
-             }
-        }
-        
-        struct timespec ts = {0, 100000000}; 
-        nanosleep(&ts, NULL);
+        wait_for_change();
+        int ch;
+        while (ui_running && (ch = getch()) != ERR) { handle_key(ch); ui_state_ver++; }
+        render_dirty(0);
     }
-    
-    delwin(w_header); delwin(w_mural); delwin(w_completed); 
-    delwin(w_tedax); delwin(w_bench); delwin(w_log); delwin(w_cmd);
-    endwin(); return NULL;
+}
+
+static void* ui_thread_fn(void *arg) {
+    (void)arg;
+    do {
+        ui_round();
+    } while (park_enter(&ui_park));
+    return NULL;
 }
 
 void ui_start(void) {
-    pthread_mutex_lock(&log_lock);
-    for(int i=0; i<LOG_LINES; i++) { 
-        if(logbuf[i]) { free(logbuf[i]); logbuf[i]=NULL; } 
+    log_reset();
+    if (wake_pipe[0] < 0 && pipe(wake_pipe) == 0) {
+        fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
     }
-    log_pos = -1;
-    pthread_mutex_unlock(&log_lock);
+    // a sessão ncurses é aberta aqui, na thread dos menus, antes da thread da UI
+    screen_open();
+    ui_running = 1;
 
-    pthread_create(&ui_thread, NULL, ui_thread_fn, NULL);
+    if (park_threads(&ui_park) > 0) park_open(&ui_park);
+    else park_spawn(&ui_park, &ui_thread, ui_thread_fn, NULL);
     log_event("[SYSTEM] UI Iniciada (Keep Solving and Nobody Explodes)");
 }
 
 void ui_stop(void) {
     ui_running = 0;
-    pthread_join(ui_thread, NULL);
-    pthread_mutex_lock(&log_lock);
-    for(int i=0; i<LOG_LINES; i++) { 
-        if(logbuf[i]) { free(logbuf[i]); logbuf[i]=NULL; } 
+    atomic_store(&ui_waiting, 1);
+    ui_wake();
+    park_close(&ui_park);
+}
+
+static void linger_init(void) {
+    sim_cond_init(&linger_cond);
+}
+
+void ui_set_linger_ms(int ms) { linger_ms = ms > 0 ? ms : 0; }
+
+void ui_linger(void) {
+    if (linger_ms <= 0 || !ui_running) return;
+    pthread_once(&linger_once, linger_init);
+    struct timespec until;
+    sim_abs_timespec(sim_now_ms() + linger_ms, &until);
+    LOCK(&linger_mutex);
+    atomic_store(&lingering, 1);
+    ui_wake();
+    int rc = 0;
+    while (atomic_load(&lingering) && rc == 0)
+        rc = COND_TIMEDWAIT(&linger_cond, &linger_mutex, &until);
+    atomic_store(&lingering, 0);
+    UNLOCK(&linger_mutex);
+}
+
+void ui_exit(void) {
+    if (park_threads(&ui_park) > 0) park_exit(&ui_park, &ui_thread);
+    delete_windows();
+    if (screen_ready) { endwin(); screen_ready = 0; }
+}
+
+void ui_wake(void) {
+    // só faz a syscall se a UI estiver mesmo dormindo
+    if (wake_pipe[1] >= 0 && atomic_exchange(&ui_waiting, 0)) {
+        char c = 1;
+        if (write(wake_pipe[1], &c, 1) < 0) { /* pipe cheio: a UI já vai acordar */ }
     }
-    pthread_mutex_unlock(&log_lock);
 }
\ No newline at end of file
@@ -1,19 +1,30 @@
 #ifndef UI_H
 #define UI_H
 
-// Inicia/Para a thread da UI
+#include "eventlog.h"
+
+// Inicia/Para a rodada da UI (a thread estaciona entre rodadas)
 void ui_start(void);
 void ui_stop(void);
 
+// Fim do programa: encerra a thread da UI e fecha a sessão ncurses
+void ui_exit(void);
+
+// Acorda o render quando algum estado visível mudou (barato se a UI não
+// estiver dormindo ou não estiver ativa)
+void ui_wake(void);
+
+// Fim de rodada: mantém o tabuleiro (já parado) na tela por até ms
+// milissegundos, ou até o jogador apertar uma tecla. 0 desliga.
+void ui_set_linger_ms(int ms);
+void ui_linger(void);
+
 // Verifica se a UI ainda está a correr (retorna 0 se o jogador carregou em Q)
 int is_ui_active(void);
 
-// Menus (Bloqueantes)
+// Menus (Bloqueantes; abrem a sessão ncurses se preciso)
 void show_start_screen(void);
 int show_main_menu_ncurses(void);
 int show_difficulty_menu_ncurses(void);
 
-// Logging
-void log_event(const char *fmt, ...);
-
 #endif // UI_H
\ No newline at end of file